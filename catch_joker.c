@@ -3,18 +3,33 @@
 #include <stdlib.h>
 #include <string.h>
 #include <errno.h>
+#include <unistd.h>
+#include <pthread.h>
 
 #include "poker.h"
 
-typedef struct search_s
+#define GAME_CHUNK  256  /* games a worker takes at a time */
+
+typedef struct batch_s
+{
+    int                 players;
+    long                games;
+    int                 quiet;
+    unsigned long long  seed;
+    long                next_game;  /* next game to take, shared by workers */
+} BATCH_T;
+
+typedef struct worker_s
 {
-    int player_no;
-    int index;
-    int card_num;
-} SEARCH_T;
+    pthread_t   thread;
+    BATCH_T     *batch;
+    long        games;
+    long        rounds;
+    long        *lose;       /* games lost by every player */
+    int         err;
+} WORKER_T;
 
 char    card_map[15][3] = { "0", "1", "2", "3", "4", "5", "6", "7", "8", "9", "10", "J", "Q", "K", "A" };
-DECK_TP deck = NULL;
 
 void dump_card(int index, int card, void *para)
 {
@@ -40,36 +55,6 @@ void dump_card(int index, int card, void *para)
     printf("[%d]%c-%s\t", index, color, card_map[POKER_Num(card)]);
 }
 
-int throw_func(int index, int card, void *para)
-{
-    SEARCH_T *search = (SEARCH_T *)para;
-    
-    if (index == search->index) return POKER_ERR; /* skip the first search card */
-    if (POKER_Num(card) == search->card_num) /* match the second search card */
-    {
-        /* throw the second search card */
-        POKER_Throw_PlayerCard(deck, search->player_no, POKER_FROM_INDEX, index);
-        return POKER_OK;
-    }
-    return POKER_NONE;
-}
-
-int search_func(int index, int card, void *para)
-{
-    SEARCH_T search;
-
-    search.player_no = *(int *)para;
-    search.index = index;
-    search.card_num = POKER_Num(card);
-    if (POKER_Search_PlayerPile(deck, search.player_no, throw_func, &search) == POKER_OK)
-    {
-        /* if match second card, throw the first card, and return for re-search others */
-        POKER_Throw_PlayerCard(deck, search.player_no, POKER_FROM_INDEX, index);
-        return POKER_OK;
-    }
-    return POKER_NONE;
-}
-
 int comp_func(int card1, int card2)
 {
     if (POKER_Color(card1) == POKER_Color(card2))
@@ -81,25 +66,22 @@ int comp_func(int card1, int card2)
     return POKER_Color(card2) - POKER_Color(card1);
 }
 
-/* argv[1]: players */
-int main(int argc, char **argv)
+/* play a game with the deck, return the player who loses and the rounds played */
+int play_game(DECK_TP deck, int players, int interactive, int *rounds)
 {
-    int players = atoi(argv[1]);
     int player_no = 0;
     int player_next = 0;
     int rand_idx = 0;
 
-    srand(time(NULL));
-
-    /* create a deck of poker */
-    deck = POKER_Create_Deck(players, 1);
+    *rounds = 0;
     /* shuffle pile */
     POKER_Shuffle_LastPile(deck);
 
-#if 1
-    POKER_Dump_LastPile(deck, dump_card, NULL);
-    printf("\n");
-#endif
+    if (interactive)
+    {
+        POKER_Dump_LastPile(deck, dump_card, NULL);
+        printf("\n");
+    }
 
 #if 0
     /* test for sorting */
@@ -109,40 +91,41 @@ int main(int argc, char **argv)
 #endif
 
     /* Deal cards */
-    player_no = 0;
-    while (POKER_Get_LastCardNum(deck) > 0)
+    if (POKER_Deal_All(deck, 1) != POKER_OK)
     {
-        if (++player_no > players) player_no = 1;
-        if (POKER_Deal_Card(deck, POKER_FROM_TOP, 0, player_no) != POKER_OK)
-        {
-            printf("ERROR: deal card fail, %s\n", strerror(errno));
-            return -1;
-        }
+        printf("ERROR: deal card fail, %s\n", strerror(errno));
+        return -1;
     }
 
 #ifdef TEST
-    printf("\nFinish to deal cards\n");
-    for (player_no = 1; player_no <= players; player_no++)
+    if (interactive)
     {
-        printf("Player %d\n", player_no);
-        POKER_Dump_PlayerPile(deck, player_no, dump_card, NULL);
-        printf("\n");
+        printf("\nFinish to deal cards\n");
+        for (player_no = 1; player_no <= players; player_no++)
+        {
+            printf("Player %d\n", player_no);
+            POKER_Dump_PlayerPile(deck, player_no, dump_card, NULL);
+            printf("\n");
+        }
     }
 #endif
     
     /* throw the same card no */
-    printf("\nThrow twice of card for the same number\n");
+    if (interactive) printf("\nThrow twice of card for the same number\n");
     for (player_no = 1; player_no <= players; player_no++)
     {
-        while (POKER_Search_PlayerPile(deck, player_no, search_func, &player_no) != POKER_NONE);
+        POKER_Throw_PlayerPair(deck, player_no, NULL, 0);
     }
 
 #ifdef TEST
-    for (player_no = 1; player_no <= players; player_no++)
+    if (interactive)
     {
-        printf("Player %d\n", player_no);
-        POKER_Dump_PlayerPile(deck, player_no, dump_card, NULL);
-        printf("\n");
+        for (player_no = 1; player_no <= players; player_no++)
+        {
+            printf("Player %d\n", player_no);
+            POKER_Dump_PlayerPile(deck, player_no, dump_card, NULL);
+            printf("\n");
+        }
     }
 #endif
 
@@ -150,8 +133,12 @@ int main(int argc, char **argv)
     /* loop for trnasfer players' card until joker card left */
     while (POKER_Get_TrashCardNum(deck) < POKER_Get_TotalCardNum(deck) - 1)
     {
-        printf("\nPress any key to turn next round ...");
-        getc(stdin);
+        if (interactive)
+        {
+            printf("\nPress any key to turn next round ...");
+            getc(stdin);
+        }
+        (*rounds)++;
         /* skip the empty-handed player */
         while (POKER_Get_PlayerCardNum(deck, player_no) == 0)
             if (++player_no > players) player_no = 1;
@@ -162,22 +149,31 @@ int main(int argc, char **argv)
             if (++player_next > players) player_next = 1;
             
         /* draw a card from next player */
-        rand_idx = rand() % POKER_Get_PlayerCardNum(deck, player_next);
-        printf("Player %d draws from %d ===> ", player_no, player_next);
-        dump_card(rand_idx, POKER_Show_PlayerCard(deck, player_next, POKER_FROM_INDEX, rand_idx), NULL);
+        rand_idx = POKER_Rand_Deck(deck, POKER_Get_PlayerCardNum(deck, player_next));
+        if (interactive)
+        {
+            printf("Player %d draws from %d ===> ", player_no, player_next);
+            dump_card(rand_idx, POKER_Show_PlayerCard(deck, player_next, POKER_FROM_INDEX, rand_idx), NULL);
+        }
         POKER_Transfer_PlayerCard(deck, POKER_FROM_INDEX, rand_idx, player_next, player_no);
 
         /* dump */
-        printf("\nPlayer %d: ", player_no);
-        POKER_Dump_PlayerPile(deck, player_no, dump_card, NULL);
-        printf("\nPlayer %d: ", player_next);
-        POKER_Dump_PlayerPile(deck, player_next, dump_card, NULL);
+        if (interactive)
+        {
+            printf("\nPlayer %d: ", player_no);
+            POKER_Dump_PlayerPile(deck, player_no, dump_card, NULL);
+            printf("\nPlayer %d: ", player_next);
+            POKER_Dump_PlayerPile(deck, player_next, dump_card, NULL);
+        }
 
         /* check the same card number and throw them */
-        printf("\nPlayer %d throw twice of card for the same number", player_no);
-        POKER_Search_PlayerPile(deck, player_no, search_func, &player_no);
-        printf("\nPlayer %d Result: ", player_no);
-        POKER_Dump_PlayerPile(deck, player_no, dump_card, NULL);
+        POKER_Throw_PlayerPair(deck, player_no, NULL, 0);
+        if (interactive)
+        {
+            printf("\nPlayer %d throw twice of card for the same number", player_no);
+            printf("\nPlayer %d Result: ", player_no);
+            POKER_Dump_PlayerPile(deck, player_no, dump_card, NULL);
+        }
 
         /* next player */
         player_no = player_next;
@@ -186,21 +182,176 @@ int main(int argc, char **argv)
     /* check who has the last joker card */
     for (player_no = 1; player_no <= players; player_no++)
     {
-        if (POKER_Get_PlayerCardNum(deck, player_no) > 0)
+        if (POKER_Get_PlayerCardNum(deck, player_no) > 0) return player_no;
+    }
+    return -1;
+}
+
+/* worker of batch mode, every game is seeded by its game no, so the result is the same for any threads */
+void *play_games(void *para)
+{
+    WORKER_T    *worker = (WORKER_T *)para;
+    BATCH_T     *batch = worker->batch;
+    DECK_TP     deck = NULL;
+    long        game = 0;
+    long        last = 0;
+    int         loser = 0;
+    int         rounds = 0;
+
+    if ((deck = POKER_Create_Deck(batch->players, 1)) == NULL)
+    {
+        worker->err = 1;
+        return NULL;
+    }
+    while ((game = __sync_fetch_and_add(&batch->next_game, GAME_CHUNK)) <= batch->games)
+    {
+        last = (game + GAME_CHUNK - 1 < batch->games) ? (game + GAME_CHUNK - 1) : batch->games;
+        for (; game <= last; game++)
         {
-            printf("\n\nPlayer %d lose the game !!\n", player_no);
-            break;
+            POKER_Seed_Deck(deck, batch->seed + game);
+            POKER_Reset_Deck(deck, 0);
+            if ((loser = play_game(deck, batch->players, 0, &rounds)) < 0)
+            {
+                worker->err = 1;
+                break;
+            }
+            worker->lose[loser]++;
+            worker->rounds += rounds;
+            worker->games++;
+            if (!batch->quiet) printf("Game %ld: player %d lose in %d rounds\n", game, loser, rounds);
         }
     }
+    POKER_Delete_Deck(&deck);
+    return NULL;
+}
+
+void usage(char *name)
+{
+    printf("usage: %s players\n", name);
+    printf("       %s -g games -p players [-s seed] [-t threads] [-q]\n", name);
+    printf("  -g games   -- play games back to back without waiting for keys\n");
+    printf("  -p players -- how many players\n");
+    printf("  -s seed    -- seed of the games, the same seed gives the same result\n");
+    printf("  -t threads -- play games in threads, 0 for all cores, default 1\n");
+    printf("  -q         -- only print the statistics\n");
+}
+
+/* argv[1]: players, or options of batch mode */
+int main(int argc, char **argv)
+{
+    DECK_TP         deck = NULL;
+    BATCH_T         batch;
+    WORKER_T        *worker = NULL;
+    int             threads = 1;
+    int             players = 0;
+    long            games = 0;
+    long            total_rounds = 0;
+    long            lose = 0;
+    int             quiet = 0;
+    int             seeded = 0;
+    unsigned long long seed = 0;
+    int             loser = 0;
+    int             rounds = 0;
+    int             opt = 0;
+    int             idx = 0;
+    int             err = 0;
+    int             player_no = 0;
+    double          elapsed = 0;
+    struct timeval  start, end;
+
+    while ((opt = getopt(argc, argv, "g:p:s:t:q")) != -1)
+    {
+        switch (opt)
+        {
+            case 'g': games = atol(optarg); break;
+            case 'p': players = atoi(optarg); break;
+            case 's': seed = strtoull(optarg, NULL, 0); seeded = 1; break;
+            case 't': threads = atoi(optarg); break;
+            case 'q': quiet = 1; break;
+            default:
+                usage(argv[0]);
+                return -1;
+        }
+    }
+    if ((players == 0) && (optind < argc)) players = atoi(argv[optind]);
+    if ((players <= 0) || (threads < 0))
+    {
+        usage(argv[0]);
+        return -1;
+    }
+
+    if (games == 0)
+    {
+        /* create a deck of poker */
+        if ((deck = POKER_Create_Deck(players, 1)) == NULL)
+        {
+            printf("ERROR: create deck fail\n");
+            return -1;
+        }
+        if (seeded) POKER_Seed_Deck(deck, seed);
+        if ((loser = play_game(deck, players, 1, &rounds)) > 0)
+            printf("\n\nPlayer %d lose the game !!\n", loser);
 
-    /* test for shuffle trash pile */
-    POKER_Shuffle_TrashPile(deck);
+        /* test for shuffle trash pile */
+        POKER_Shuffle_TrashPile(deck);
 #if 0
-    POKER_Dump_LastPile(deck, dump_card, NULL);
-    printf("\n");
+        POKER_Dump_LastPile(deck, dump_card, NULL);
+        printf("\n");
 #endif
+        POKER_Delete_Deck(&deck);
+        return 0;
+    }
 
-    POKER_Delete_Deck(&deck);
-    return 0;
-}
+    /* batch mode: every worker reuses its own deck for its games */
+    if (threads == 0) threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    if (threads <= 0) threads = 1;
+    if (!seeded) seed = (unsigned long long)time(NULL);
+    batch.players = players;
+    batch.games = games;
+    batch.quiet = quiet;
+    batch.seed = seed;
+    batch.next_game = 1;
+    if ((worker = (WORKER_T *)calloc(threads, sizeof(WORKER_T))) == NULL) return -1;
+    for (idx = 0; idx < threads; idx++)
+    {
+        worker[idx].batch = &batch;
+        if ((worker[idx].lose = (long *)calloc(players + 1, sizeof(long))) == NULL) err = 1;
+    }
 
+    gettimeofday(&start, NULL);
+    for (idx = 0; (idx < threads) && !err; idx++)
+    {
+        if (pthread_create(&worker[idx].thread, NULL, play_games, &worker[idx]) != 0)
+        {
+            printf("ERROR: create thread fail, %s\n", strerror(errno));
+            threads = idx;
+            err = 1;
+        }
+    }
+    for (idx = 0; idx < threads; idx++) pthread_join(worker[idx].thread, NULL);
+    gettimeofday(&end, NULL);
+    elapsed = (end.tv_sec - start.tv_sec) + (end.tv_usec - start.tv_usec) / 1000000.0;
+
+    /* merge the statistics of workers */
+    games = 0;
+    for (idx = 0; idx < threads; idx++)
+    {
+        games += worker[idx].games;
+        total_rounds += worker[idx].rounds;
+        if (worker[idx].err) err = 1;
+    }
+    if (err) printf("ERROR: batch mode fail\n");
+
+    printf("games: %ld, players: %d, seed: %llu, threads: %d\n", games, players, seed, threads);
+    for (player_no = 1; player_no <= players; player_no++)
+    {
+        for (lose = 0, idx = 0; idx < threads; idx++) lose += worker[idx].lose[player_no];
+        printf("player %d lose: %ld (%.2f%%)\n", player_no, lose, (games > 0) ? lose * 100.0 / games : 0.0);
+    }
+    printf("average rounds: %.2f\n", (games > 0) ? (double)total_rounds / games : 0.0);
+    printf("games per second: %.0f\n", (elapsed > 0) ? games / elapsed : 0.0);
+
+    for (idx = 0; idx < threads; idx++) free(worker[idx].lose);
+    free(worker);
+    return err ? -1 : 0;
+}
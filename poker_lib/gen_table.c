@@ -0,0 +1,314 @@
+/* generator of hand evaluator tables, run at build time:
+   * gen_table > poker_table.c
+   * writes the tables of poker_table.h as read only data, exits with 1 if the hash does not fit */
+#include "poker.h"
+#include "poker_table.h"
+
+#define EVAL_HASH_SIZE  (1 << 17)     /* first fit of rows takes 124702 */
+
+/* the sum of keys of 7 numbers (4 cards of a number at most) is unique and less than EVAL_KEY_CARD,
+   the card number above it makes the sum of 5 ~ 7 numbers unique */
+static const int num_key[EVAL_NUM] =
+{
+    EVAL_KEY_CARD + 0, EVAL_KEY_CARD + 1, EVAL_KEY_CARD + 5, EVAL_KEY_CARD + 22,
+    EVAL_KEY_CARD + 98, EVAL_KEY_CARD + 453, EVAL_KEY_CARD + 2031, EVAL_KEY_CARD + 8698,
+    EVAL_KEY_CARD + 22854, EVAL_KEY_CARD + 83661, EVAL_KEY_CARD + 262349, EVAL_KEY_CARD + 636345,
+    EVAL_KEY_CARD + 1479181
+};
+
+static signed char card_bit[256];
+static unsigned short flush_value[EVAL_FLUSH_SIZE];
+static unsigned short hash_value[EVAL_HASH_SIZE];
+static int hash_offset[EVAL_ROW_NUM];
+static int hash_size = 0;
+
+/* score of the best 5 cards, hand type in bit 20 ~ 23 and 5 numbers (0 ~ 12) in bit 0 ~ 19,
+   a bigger score is a better hand */
+#define SCORE(type, n1, n2, n3, n4, n5) \
+    (((type) << 20) | ((n1) << 16) | ((n2) << 12) | ((n3) << 8) | ((n4) << 4) | (n5))
+
+/* the highest number of a straight in the number bits, -1 for none */
+static int straight_top(int bits)
+{
+    int top = 0;
+
+    for (top = EVAL_NUM - 1; top >= 4; top--)
+    {
+        if (((bits >> (top - 4)) & 0x1F) == 0x1F) return top;
+    }
+    /* 5, 4, 3, 2, A */
+    if ((bits & 0x100F) == 0x100F) return 3;
+    return -1;
+}
+
+/* take the n highest numbers from bits into top */
+static void high_nums(int bits, int *top, int n)
+{
+    int num = 0;
+    int idx = 0;
+
+    for (num = EVAL_NUM - 1; (num >= 0) && (idx < n); num--)
+    {
+        if (bits & (1 << num)) top[idx++] = num;
+    }
+    while (idx < n) top[idx++] = 0;
+}
+
+static int score_flush(int bits)
+{
+    int top[5];
+    int num = straight_top(bits);
+
+    if (num >= 0) return SCORE(POKER_HAND_STRAIGHT_FLUSH, num, 0, 0, 0, 0);
+    high_nums(bits, top, 5);
+    return SCORE(POKER_HAND_FLUSH, top[0], top[1], top[2], top[3], top[4]);
+}
+
+/* count -- card number of every number, no flush in hand */
+static int score_nums(const int *count)
+{
+    int bits = 0;
+    int quad = -1;
+    int trip = -1;
+    int pair1 = -1;
+    int pair2 = -1;
+    int num = 0;
+    int top[5];
+
+    for (num = EVAL_NUM - 1; num >= 0; num--)
+    {
+        if (count[num] == 0) continue;
+        bits |= 1 << num;
+        if ((count[num] == 4) && (quad < 0)) quad = num;
+        else if ((count[num] == 3) && (trip < 0)) trip = num;
+        else if (count[num] >= 2)
+        {
+            /* the second trips is a pair of full house */
+            if (pair1 < 0) pair1 = num;
+            else if (pair2 < 0) pair2 = num;
+        }
+    }
+
+    if (quad >= 0)
+    {
+        high_nums(bits & ~(1 << quad), top, 1);
+        return SCORE(POKER_HAND_FOUR_OF_A_KIND, quad, top[0], 0, 0, 0);
+    }
+    if ((trip >= 0) && (pair1 >= 0)) return SCORE(POKER_HAND_FULL_HOUSE, trip, pair1, 0, 0, 0);
+    if ((num = straight_top(bits)) >= 0) return SCORE(POKER_HAND_STRAIGHT, num, 0, 0, 0, 0);
+    if (trip >= 0)
+    {
+        high_nums(bits & ~(1 << trip), top, 2);
+        return SCORE(POKER_HAND_THREE_OF_A_KIND, trip, top[0], top[1], 0, 0);
+    }
+    if (pair2 >= 0)
+    {
+        high_nums(bits & ~(1 << pair1) & ~(1 << pair2), top, 1);
+        return SCORE(POKER_HAND_TWO_PAIR, pair1, pair2, top[0], 0, 0);
+    }
+    if (pair1 >= 0)
+    {
+        high_nums(bits & ~(1 << pair1), top, 3);
+        return SCORE(POKER_HAND_ONE_PAIR, pair1, top[0], top[1], top[2], 0);
+    }
+    high_nums(bits, top, 5);
+    return SCORE(POKER_HAND_HIGH_CARD, top[0], top[1], top[2], top[3], top[4]);
+}
+
+static int comp_score(const void *score1, const void *score2)
+{
+    return *(const int *)score1 - *(const int *)score2;
+}
+
+/* value of a score is its position in all different 5 card hands */
+static int score_value(const int *scores, int score)
+{
+    int low = 0;
+    int high = EVAL_HAND_NUM - 1;
+    int mid = 0;
+
+    while (low < high)
+    {
+        mid = (low + high) / 2;
+        if (scores[mid] < score) low = mid + 1;
+        else high = mid;
+    }
+    return low + 1;
+}
+
+static int count_bits(int bits)
+{
+    int num = 0;
+
+    for (; bits; bits &= bits - 1) num++;
+    return num;
+}
+
+/* list every number combination of 5 ~ max cards: its key into keys and score into scores,
+   return the number of combinations */
+static int list_nums(int *count, int num, int max, int left, int key, int *keys, int *scores, int total)
+{
+    int card_num = 0;
+
+    if (num == EVAL_NUM)
+    {
+        if (max - left < EVAL_MIN_CARD) return total;
+        keys[total] = key - EVAL_KEY_MIN;
+        scores[total] = score_nums(count);
+        return total + 1;
+    }
+    for (card_num = 0; (card_num <= 4) && (card_num <= left); card_num++)
+    {
+        count[num] = card_num;
+        total = list_nums(count, num + 1, max, left - card_num, key + card_num * num_key[num], keys, scores, total);
+    }
+    count[num] = 0;
+    return total;
+}
+
+/* place rows of keys into hash_value, a row is the keys with same bits above EVAL_HASH_SHIFT,
+   rows with more keys first, every row at the first offset without collision */
+static int build_hash(int *keys, int *scores, int total, const int *values)
+{
+    static int row_size[EVAL_ROW_NUM];
+    static int row_start[EVAL_ROW_NUM + 1];
+    static int row_order[EVAL_ROW_NUM];
+    static int row_key[EVAL_HASH_SIZE];
+    static unsigned char used[EVAL_HASH_SIZE];
+    int row = 0;
+    int rows = 0;
+    int idx = 0;
+    int offset = 0;
+    int size = 0;
+    int free = 0;
+
+    for (idx = 0; idx < total; idx++) row_size[keys[idx] >> EVAL_HASH_SHIFT]++;
+    for (row = 0; row < EVAL_ROW_NUM; row++)
+    {
+        row_start[row + 1] = row_start[row] + row_size[row];
+        row_size[row] = 0;
+    }
+    for (idx = 0; idx < total; idx++)
+    {
+        row = keys[idx] >> EVAL_HASH_SHIFT;
+        row_key[row_start[row] + row_size[row]++] = idx;
+    }
+
+    /* order rows by size, descending */
+    for (size = EVAL_HASH_MASK + 1; size > 0; size--)
+    {
+        for (row = 0; row < EVAL_ROW_NUM; row++)
+        {
+            if (row_size[row] == size) row_order[rows++] = row;
+        }
+    }
+
+    for (idx = 0; idx < rows; idx++)
+    {
+        row = row_order[idx];
+        /* no key fits below the first free slot */
+        while (used[free]) free++;
+        for (offset = (free > EVAL_HASH_MASK) ? free - EVAL_HASH_MASK : 0; offset < EVAL_HASH_SIZE - EVAL_HASH_MASK; offset++)
+        {
+            for (size = 0; size < row_size[row]; size++)
+            {
+                if (used[offset + (keys[row_key[row_start[row] + size]] & EVAL_HASH_MASK)]) break;
+            }
+            if (size == row_size[row]) break;
+        }
+        if (offset == EVAL_HASH_SIZE - EVAL_HASH_MASK) return POKER_ERR;
+        hash_offset[row] = offset;
+        for (size = 0; size < row_size[row]; size++)
+        {
+            int key_idx = row_key[row_start[row] + size];
+            /* same key twice, the number keys are not unique */
+            if (used[offset + (keys[key_idx] & EVAL_HASH_MASK)]) return POKER_ERR;
+            used[offset + (keys[key_idx] & EVAL_HASH_MASK)] = 1;
+            hash_value[offset + (keys[key_idx] & EVAL_HASH_MASK)] = score_value(values, scores[key_idx]);
+            if (offset + (keys[key_idx] & EVAL_HASH_MASK) >= hash_size) hash_size = offset + (keys[key_idx] & EVAL_HASH_MASK) + 1;
+        }
+    }
+    return POKER_OK;
+}
+
+static int build_tables(void)
+{
+    static int scores[EVAL_HAND_NUM];
+    static int hand_keys[EVAL_HASH_SIZE];
+    static int hand_scores[EVAL_HASH_SIZE];
+    int count[EVAL_NUM];
+    int bits = 0;
+    int total = 0;
+    int idx = 0;
+
+    for (idx = 0; idx < 256; idx++)
+    {
+        card_bit[idx] = -1;
+        if ((POKER_Color(idx) < POKER_COLOR_CLUB) || (POKER_Color(idx) > POKER_COLOR_SPADE)) continue;
+        if ((POKER_Num(idx) < POKER_NUM_2) || (POKER_Num(idx) > POKER_NUM_A)) continue;
+        card_bit[idx] = ((POKER_Color(idx) >> 4) - 2) * 16 + POKER_Num(idx) - POKER_NUM_2;
+    }
+
+    /* all different 5 card hands: 5 numbers of a flush, and 5 cards of numbers without flush */
+    for (bits = 0; bits < EVAL_FLUSH_SIZE; bits++)
+    {
+        if (count_bits(bits) == EVAL_MIN_CARD) scores[total++] = score_flush(bits);
+    }
+    memset(count, 0, sizeof(count));
+    idx = list_nums(count, 0, EVAL_MIN_CARD, EVAL_MIN_CARD, 0, hand_keys, hand_scores, 0);
+    memcpy(scores + total, hand_scores, idx * sizeof(int));
+    total += idx;
+    qsort(scores, total, sizeof(int), comp_score);
+    for (idx = 1, bits = 1; idx < total; idx++)
+    {
+        if (scores[idx] != scores[bits - 1]) scores[bits++] = scores[idx];
+    }
+    if (bits != EVAL_HAND_NUM) return POKER_ERR;
+
+    for (bits = 0; bits < EVAL_FLUSH_SIZE; bits++)
+    {
+        if (count_bits(bits) >= EVAL_MIN_CARD) flush_value[bits] = score_value(scores, score_flush(bits));
+    }
+    memset(count, 0, sizeof(count));
+    total = list_nums(count, 0, EVAL_MAX_CARD, EVAL_MAX_CARD, 0, hand_keys, hand_scores, 0);
+    return build_hash(hand_keys, hand_scores, total, scores);
+}
+
+static void print_table(const char *decl, const int *table, int num)
+{
+    int idx = 0;
+
+    printf("\n%s[%d] =\n{", decl, num);
+    for (idx = 0; idx < num; idx++)
+    {
+        printf("%s%d%s", (idx % 12) ? " " : "\n    ", table[idx], (idx < num - 1) ? "," : "");
+    }
+    printf("\n};\n");
+}
+
+int main(void)
+{
+    static int table[EVAL_HASH_SIZE + 1];
+    int idx = 0;
+
+    if (build_tables() != POKER_OK)
+    {
+        fprintf(stderr, "gen_table: hash of hand values does not fit in %d\n", EVAL_HASH_SIZE);
+        return 1;
+    }
+
+    printf("/* poker_table.c: generated by gen_table, do not edit */\n");
+    printf("#include \"poker_table.h\"\n");
+    print_table("const int poker_num_key", num_key, EVAL_NUM);
+    for (idx = 0; idx < 256; idx++) table[idx] = card_bit[idx];
+    print_table("const signed char poker_card_bit", table, 256);
+    /* one more value of 0 for 32 bits gathers of the last value */
+    for (idx = 0; idx < EVAL_FLUSH_SIZE; idx++) table[idx] = flush_value[idx];
+    table[EVAL_FLUSH_SIZE] = 0;
+    print_table("const unsigned short poker_flush_value", table, EVAL_FLUSH_SIZE + 1);
+    for (idx = 0; idx < hash_size; idx++) table[idx] = hash_value[idx];
+    table[hash_size] = 0;
+    print_table("const unsigned short poker_hash_value", table, hash_size + 1);
+    print_table("const int poker_hash_offset", hash_offset, EVAL_ROW_NUM);
+    return 0;
+}
@@ -1,18 +1,21 @@
 /* poker library */
-#include "poker.h"
+#include <stdint.h>
+#include <stdarg.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
 
-struct card_s
-{
-    int             card;
-    struct card_s   *next;
-    struct card_s   *prev;
-};
+#include "poker.h"
+#include "poker_log.h"
 
 struct pile_s
 {
-    struct card_s   *top;
-    struct card_s   *bottom;
+    struct card_s   *top;        /* top card, list type */
+    struct card_s   *bottom;     /* bottom card, list type */
+    int             *slot;       /* ring buffer of cards, array type */
+    int             head;        /* slot of top card, array type */
     int             card_num;
+    CARDSET_T       set;         /* cards in pile, POKER_DECK_CARDSET */
 };
 
 struct deck_s
@@ -22,9 +25,68 @@ struct deck_s
     struct pile_s   *player;     /* players' pile */
     int             total_num;
     int             joker_num;
+    int             pack_num;    /* packs of a shoe */
+    int             cut_num;     /* cards of last pile behind the cut card */
     int             player_num;
+    int             type;        /* POKER_DECK_LIST or POKER_DECK_ARRAY */
+    int             cardset;     /* keep card set of piles */
+    int             mask;        /* slot capacity - 1, array type */
+    struct card_s   *card;       /* all cards, list type */
+    int             *scratch;    /* working space of total_num cards */
+    uint64_t        rand_state[4]; /* xoshiro256** state */
+    int             allocated;   /* memory block is allocated by library */
+    struct log_s    *log;        /* log of POKER_Open_Log, NULL for none */
+    int             cursor;      /* a cursor is open, other calls fail till POKER_End_Cursor */
+#ifdef POKER_STAT
+    STAT_T          stat;        /* counters of POKER_Get_DeckStat */
+#endif
 };
 
+/* the card at index of an array type pile */
+#define SLOT(deck, pile, index)  ((pile)->slot[((pile)->head + (index)) & (deck)->mask])
+
+/* scratch size rounded up to keep the cards behind it aligned */
+#define SCRATCH_SIZE(total)  (((total) * sizeof(int) + sizeof(void *) - 1) / sizeof(void *) * sizeof(void *))
+
+/* counters of a deck, nothing is left of them without POKER_STAT */
+#ifdef POKER_STAT
+#define STAT_ADD(deck, field, num)  ((deck)->stat.field += (num))
+#define STAT_TIME(deck, op, stmt) \
+    do { long long stat_begin = stat_now(); stmt; stat_time((deck), (op), stat_begin); } while (0)
+#define COMPARE(deck, comp_func, card1, card2)  ((deck)->stat.compares++, (comp_func)((card1), (card2)))
+
+static long long stat_now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static void stat_time(DECK_T *deck, int op, long long begin)
+{
+    deck->stat.calls[op]++;
+    deck->stat.ns[op] += stat_now() - begin;
+}
+#else
+#define STAT_ADD(deck, field, num)  ((void)0)
+#define STAT_TIME(deck, op, stmt)   stmt
+#define COMPARE(deck, comp_func, card1, card2)  (comp_func)((card1), (card2))
+#endif
+
+typedef struct log_s LOG_T;
+
+static void shuffle_pile(DECK_T *deck, PILE_T *pile);
+static void log_op(DECK_T *deck, int op, int num, ...);
+static void log_snapshot(DECK_T *deck);
+static void log_sort(DECK_T *deck, int pile_no, int (*comp_func)(int card1, int card2));
+
+/* record an operation in the log of deck */
+#define LOG_OP(deck, ...)  do { if ((deck)->log != NULL) log_op((deck), __VA_ARGS__); } while (0)
+
+/* the index of a logged operation, it is not used but for POKER_FROM_INDEX */
+#define LOG_INDEX(type, index)  ((((type) == POKER_FROM_INDEX) && ((index) > 0)) ? (index) : 0)
+
 static void swap(int *card1, int *card2)
 {
     int tmp = *card1;
@@ -71,7 +133,27 @@ static int insert_card(PILE_T *pile, CARD_T *card, int type)
     return POKER_OK;
 }
 
-static CARD_T *remove_card(PILE_T *pile, int type, int index)
+static void unlink_card(PILE_T *pile, CARD_T *card)
+{
+    if (card == pile->top)
+    {
+        pile->top = pile->top->next;
+        if (pile->top != NULL) pile->top->prev = NULL;
+    }
+    else if (card == pile->bottom)
+    {
+        pile->bottom = pile->bottom->prev;
+        if (pile->bottom != NULL) pile->bottom->next = NULL;
+    }
+    else
+    {
+        card->next->prev = card->prev;
+        card->prev->next = card->next;
+    }
+    pile->card_num--;
+}
+
+static CARD_T *remove_card(DECK_T *deck, PILE_T *pile, int type, int index)
 {
     CARD_T *card = NULL;
 
@@ -85,582 +167,2341 @@ static CARD_T *remove_card(PILE_T *pile, int type, int index)
             card = pile->bottom;
             break;
         case POKER_FROM_INDEX:
+            if (pile->card_num <= index) return NULL;
+            STAT_ADD(deck, walks, index);
             card = pile->top;
             while (index-- > 0) card = card->next;
             break;
         default:
             return NULL;
     }
-    if (card == pile->top)
+    unlink_card(pile, card);
+    return card;
+}
+
+static int array_insert(DECK_T *deck, PILE_T *pile, int card, int type)
+{
+    switch (type)
     {
-        pile->top = pile->top->next;
-        if (pile->top != NULL) pile->top->prev = NULL;
+        case POKER_FROM_TOP:
+            pile->head = (pile->head - 1) & deck->mask;
+            pile->slot[pile->head] = card;
+            break;
+        case POKER_FROM_BOTTOM:
+            SLOT(deck, pile, pile->card_num) = card;
+            break;
+        default:
+            return POKER_ERR;
     }
-    else if (card == pile->bottom)
+    pile->card_num++;
+    return POKER_OK;
+}
+
+static int array_remove(DECK_T *deck, PILE_T *pile, int type, int index)
+{
+    int card = 0;
+    int idx = 0;
+
+    if (pile->card_num == 0) return POKER_ERR;
+    switch (type)
     {
-        pile->bottom = pile->bottom->prev;
-        if (pile->bottom != NULL) pile->bottom->next = NULL;
+        case POKER_FROM_TOP:
+            index = 0;
+            break;
+        case POKER_FROM_BOTTOM:
+            index = pile->card_num - 1;
+            break;
+        case POKER_FROM_INDEX:
+            if (pile->card_num <= index) return POKER_ERR;
+            if (index < 0) index = 0;
+            break;
+        default:
+            return POKER_ERR;
+    }
+    card = SLOT(deck, pile, index);
+    /* close the gap from the nearer end */
+    if (index < pile->card_num / 2)
+    {
+        STAT_ADD(deck, shifts, index);
+        for (idx = index; idx > 0; idx--) SLOT(deck, pile, idx) = SLOT(deck, pile, idx - 1);
+        pile->head = (pile->head + 1) & deck->mask;
     }
     else
     {
-        card->next->prev = card->prev;
-        card->prev->next = card->next;
+        STAT_ADD(deck, shifts, pile->card_num - 1 - index);
+        for (idx = index; idx < pile->card_num - 1; idx++) SLOT(deck, pile, idx) = SLOT(deck, pile, idx + 1);
     }
     pile->card_num--;
     return card;
 }
 
-/* POKER_Create_Deck: create a deck of poker, priority is from spade A to club K
-   * paremeter: int players -- how many players
-                int joker_num -- how many joker cards
-   * return value: the pointer to a deck of poker */
-DECK_TP POKER_Create_Deck(int players, int joker_num)
+/* show a card of pile without removing it */
+static int peek_card(DECK_T *deck, PILE_T *pile, int type, int index)
 {
-    DECK_TP deck = NULL;
-    int     color = 0;
-    int     number = 0;
-    int     joker = 0x01;
-    CARD_T  *card = NULL;
+    CARD_T *card = NULL;
 
-    /* set random seed */
-    srand(time(NULL));
+    if (pile->card_num == 0) return POKER_ERR;
+    switch (type)
+    {
+        case POKER_FROM_TOP:
+            index = 0;
+            break;
+        case POKER_FROM_BOTTOM:
+            index = pile->card_num - 1;
+            break;
+        case POKER_FROM_INDEX:
+            if (pile->card_num <= index) return POKER_ERR;
+            if (index < 0) index = 0;
+            break;
+        default:
+            return POKER_ERR;
+    }
+    if (deck->type == POKER_DECK_ARRAY) return SLOT(deck, pile, index);
 
-    if ((joker_num < 0) || (players < 0)) return NULL;
-    if ((deck = (DECK_T *)calloc(1, sizeof(DECK_T))) == NULL) return NULL;
+    if (index == pile->card_num - 1) return pile->bottom->card;
+    STAT_ADD(deck, walks, index);
+    card = pile->top;
+    while (index-- > 0) card = card->next;
+    return card->card;
+}
 
-    deck->joker_num = joker_num;
-    deck->total_num = POKER_CARD_NUM + joker_num;
-    deck->player_num = players;
+/* cards behind the cut card of num cards from index of a pile, the cut card stays in front of the same
+   card if they are taken out, 0 but for last pile */
+static int cut_behind(DECK_T *deck, PILE_T *from, int index, int num)
+{
+    int front = 0;
+    int behind = 0;
+
+    if (from != &deck->last_pile) return 0;
+    front = from->card_num - deck->cut_num;
+    behind = index + num - ((index > front) ? index : front);
+    return (behind > 0) ? behind : 0;
+}
+
+/* move a card from a pile to another */
+static int pass_card(DECK_T *deck, PILE_T *from, int type, int index, PILE_T *to, int to_type)
+{
+    CARD_T  *card = NULL;
+    int     value = 0;
+    int     behind = 0;
 
-    for (color = POKER_COLOR_SPADE; color >= POKER_COLOR_CLUB; color -= 0x10)
+    /* a card taken from behind the cut card moves the cut card, as splice_pile */
+    if (type == POKER_FROM_TOP) behind = cut_behind(deck, from, 0, 1);
+    else if (type == POKER_FROM_BOTTOM) behind = cut_behind(deck, from, from->card_num - 1, 1);
+    else behind = cut_behind(deck, from, index, 1);
+    if (deck->type == POKER_DECK_ARRAY)
     {
-        if ((card = (CARD_T *)calloc(1, sizeof(CARD_T))) == NULL)
-        {
-            POKER_Delete_Deck(&deck);
-            return NULL;
-        }
-        card->card = color | POKER_NUM_A;
-        insert_card(&deck->last_pile, card, POKER_FROM_BOTTOM);
-        for (number = POKER_NUM_2; number <= POKER_NUM_K; number += 0x01)
-        {
-            if ((card = (CARD_T *)calloc(1, sizeof(CARD_T))) == NULL)
-            {
-                POKER_Delete_Deck(&deck);
-                return NULL;
-            }
-            card->card = color | number;
-            insert_card(&deck->last_pile, card, POKER_FROM_BOTTOM);
-        }
+        if ((value = array_remove(deck, from, type, index)) == POKER_ERR) return POKER_ERR;
+        array_insert(deck, to, value, to_type);
     }
-    while (joker_num-- > 0)
+    else
     {
-        if ((card = (CARD_T *)calloc(1, sizeof(CARD_T))) == NULL)
-        {
-            POKER_Delete_Deck(&deck);
-            return NULL;
-        }
-        card->card = POKER_COLOR_JOKER | joker;
-        insert_card(&deck->last_pile, card, POKER_FROM_BOTTOM);
-        joker += 0x01;
+        if ((card = remove_card(deck, from, type, index)) == NULL) return POKER_ERR;
+        insert_card(to, card, to_type);
+        value = card->card;
     }
-
-    if ((deck->player = (PILE_T *)calloc(deck->player_num, sizeof(PILE_T))) == NULL)
+    if (deck->cardset)
     {
-        POKER_Delete_Deck(&deck);
-        return NULL;
+        from->set &= ~POKER_Card_Bit(value);
+        to->set |= POKER_Card_Bit(value);
     }
-    return deck;
+    deck->cut_num -= behind;
+    return POKER_OK;
 }
 
-static void destroy_pile(PILE_T *pile)
+/* copy num cards from index of a ring to index of another ring in memory blocks,
+   the two rings could be the same pile */
+static void ring_copy(DECK_T *deck, PILE_T *to, int to_idx, PILE_T *from, int from_idx, int num)
 {
-    CARD_T *card = NULL;
-    while (pile->top != NULL)
+    int src = 0;
+    int dst = 0;
+    int chunk = 0;
+
+    if ((to == from) && (to_idx > from_idx))
+    {
+        /* overlapped move to the back, copy from the last card */
+        while (num > 0)
+        {
+            src = (from->head + from_idx + num - 1) & deck->mask;
+            dst = (to->head + to_idx + num - 1) & deck->mask;
+            chunk = num;
+            if (chunk > src + 1) chunk = src + 1;
+            if (chunk > dst + 1) chunk = dst + 1;
+            memmove(&to->slot[dst - chunk + 1], &from->slot[src - chunk + 1], chunk * sizeof(int));
+            num -= chunk;
+        }
+        return;
+    }
+    while (num > 0)
     {
-        card = pile->top->next;
-        free(pile->top);
-        pile->top = card;
+        src = (from->head + from_idx) & deck->mask;
+        dst = (to->head + to_idx) & deck->mask;
+        chunk = num;
+        if (chunk > deck->mask + 1 - src) chunk = deck->mask + 1 - src;
+        if (chunk > deck->mask + 1 - dst) chunk = deck->mask + 1 - dst;
+        memmove(&to->slot[dst], &from->slot[src], chunk * sizeof(int));
+        from_idx += chunk;
+        to_idx += chunk;
+        num -= chunk;
     }
 }
 
-/* POKER_Delete_Deck: delete a deck of poker */
-void POKER_Delete_Deck(DECK_TP *deck)
+/* move num cards from index of a pile onto top or bottom of another pile, order of cards is kept,
+   parameters are checked by caller */
+static void splice_pile(DECK_T *deck, PILE_T *from, int index, int num, PILE_T *to, int type)
 {
-    int idx = 0;
-    if ((deck == NULL) || (*deck == NULL)) return;
-    
-    destroy_pile(&(*deck)->last_pile);
-    destroy_pile(&(*deck)->trash_pile);
-    if ((*deck)->player != NULL)
+    CARD_T      *start = NULL;
+    CARD_T      *end = NULL;
+    CARD_T      *card = NULL;
+    CARDSET_T   set = 0;
+    int         idx = 0;
+
+    if (num == 0) return;
+
+    /* keep the cut card in place */
+    deck->cut_num -= cut_behind(deck, from, index, num);
+    if ((to == &deck->last_pile) && (type == POKER_FROM_BOTTOM)) deck->cut_num += num;
+
+    if (deck->type == POKER_DECK_ARRAY)
     {
-        for (idx = 0; idx < (*deck)->player_num; idx++)
-            destroy_pile(&(*deck)->player[idx]);
-        free((*deck)->player);
+        if (type == POKER_FROM_TOP)
+        {
+            to->head = (to->head - num) & deck->mask;
+            ring_copy(deck, to, 0, from, index, num);
+        }
+        else
+        {
+            ring_copy(deck, to, to->card_num, from, index, num);
+        }
+        to->card_num += num;
+        if (deck->cardset)
+        {
+            for (idx = 0; idx < num; idx++) set |= POKER_Card_Bit(SLOT(deck, from, index + idx));
+        }
+
+        /* close the gap from the shorter side */
+        if (index < from->card_num - index - num)
+        {
+            ring_copy(deck, from, num, from, 0, index);
+            from->head = (from->head + num) & deck->mask;
+        }
+        else
+        {
+            ring_copy(deck, from, index, from, index + num, from->card_num - index - num);
+        }
+        from->card_num -= num;
     }
-    free(*deck);
-    *deck = NULL;
+    else
+    {
+        /* find the cards of both ends from the nearer end of pile */
+        if (index == 0) start = from->top;
+        else if (index < from->card_num / 2)
+            for (start = from->top, idx = 0; idx < index; idx++) start = start->next;
+        else
+            for (start = from->bottom, idx = from->card_num - 1; idx > index; idx--) start = start->prev;
+        if (index + num == from->card_num) end = from->bottom;
+        else
+            for (end = start, idx = 1; idx < num; idx++) end = end->next;
+        STAT_ADD(deck, walks, (index < from->card_num / 2) ? index : (from->card_num - 1 - index));
+        if (index + num != from->card_num) STAT_ADD(deck, walks, num - 1);
+        if (deck->cardset)
+        {
+            if (num == from->card_num) set = from->set;
+            else for (card = start, idx = 0; idx < num; idx++, card = card->next) set |= POKER_Card_Bit(card->card);
+        }
+
+        /* cut out */
+        if (start->prev == NULL) from->top = end->next;
+        else start->prev->next = end->next;
+        if (end->next == NULL) from->bottom = start->prev;
+        else end->next->prev = start->prev;
+        from->card_num -= num;
+
+        /* link to */
+        if (to->top == NULL)
+        {
+            start->prev = end->next = NULL;
+            to->top = start;
+            to->bottom = end;
+        }
+        else if (type == POKER_FROM_TOP)
+        {
+            start->prev = NULL;
+            end->next = to->top;
+            to->top->prev = end;
+            to->top = start;
+        }
+        else
+        {
+            end->next = NULL;
+            start->prev = to->bottom;
+            to->bottom->next = start;
+            to->bottom = end;
+        }
+        to->card_num += num;
+    }
+    from->set &= ~set;
+    to->set |= set;
 }
 
-/* POKER_Get_TotalCardNum: get total card number,
-   * parameter: DECK_TP deck -- the pointer to a deck of poker
-   * return value: the total card number    */
-int POKER_Get_TotalCardNum(DECK_TP deck)
+/* move all cards of a pile to the bottom of another */
+static void append_pile(DECK_T *deck, PILE_T *from, PILE_T *to)
 {
-    if (deck == NULL) return POKER_ERR;
-    return deck->total_num;
+    splice_pile(deck, from, 0, from->card_num, to, POKER_FROM_BOTTOM);
 }
 
-/* POKER_Get_LastCardNum: get card number of last pile,
-   * parameter: DECK_TP deck -- the pointer to a deck of poker
-   * return value: the card number of last pile  */
-int POKER_Get_LastCardNum(DECK_TP deck)
+/* the pile of pile_no, NULL for invalid pile_no */
+static PILE_T *get_pile(DECK_T *deck, int pile_no)
 {
-    if (deck == NULL) return POKER_ERR;
-    return deck->last_pile.card_num;
+    if (pile_no == POKER_PILE_LAST) return &deck->last_pile;
+    if (pile_no == POKER_PILE_TRASH) return &deck->trash_pile;
+    if ((pile_no < 1) || (pile_no > deck->player_num)) return NULL;
+    return &deck->player[pile_no-1];
 }
 
-/* POKER_Get_TrashCardNum: get card number of trash pile,
-   * parameter: DECK_TP deck -- the pointer to a deck of poker
-   * return value: the card number of trash pile  */
-int POKER_Get_TrashCardNum(DECK_TP deck)
+/* put a new card at the bottom of last pile */
+static int new_card(DECK_T *deck, int value)
 {
-    if (deck == NULL) return POKER_ERR;
-    return deck->trash_pile.card_num;
+    CARD_T *card = NULL;
+
+    if (deck->cardset) deck->last_pile.set |= POKER_Card_Bit(value);
+    if (deck->type == POKER_DECK_ARRAY)
+        return array_insert(deck, &deck->last_pile, value, POKER_FROM_BOTTOM);
+
+    /* cards are created in order, the count of last pile is the next free node */
+    card = &deck->card[deck->last_pile.card_num];
+    card->card = value;
+    return insert_card(&deck->last_pile, card, POKER_FROM_BOTTOM);
 }
 
-/* POKER_Get_PlayerNum: get card number of player pile,
-   * parameter: DECK_TP deck -- the pointer to a deck of poker
-                int player_no -- the player_no
-   * return value: the card number of player pile  */
-int POKER_Get_PlayerCardNum(DECK_TP deck, int player_no)
+static uint64_t splitmix64(uint64_t *x)
 {
-    if (deck == NULL) return POKER_ERR;
-    if (deck->player == NULL) return POKER_ERR;
-    if (deck->player_num < player_no) return POKER_ERR;
-    return deck->player[player_no-1].card_num;
+    uint64_t z = (*x += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
 }
 
-/* POKER_Show_LastCard: show a card from last_pile, 
-   * parameter: DECK_TP deck -- the pointer to a deck of poker
-                int type -- from top, bottom or index
-                int index -- from the index of last pile
-   * return value: card number for success, POKER_ERR for failure   */
-int POKER_Show_LastCard(DECK_TP deck, int type, int index)
+#define ROTL(x, k)  (((x) << (k)) | ((x) >> (64 - (k))))
+
+/* xoshiro256** of the deck */
+static uint64_t rand_next(DECK_T *deck)
 {
-    CARD_T *card = NULL;
+    uint64_t *s = deck->rand_state;
+    uint64_t result = ROTL(s[1] * 5, 7) * 9;
+    uint64_t t = s[1] << 17;
 
-    if (deck == NULL) return POKER_ERR;
-    if (deck->last_pile.card_num == 0) return POKER_ERR;
-    if (deck->last_pile.card_num <= index) return POKER_ERR;
-    
-    switch (type)
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = ROTL(s[3], 45);
+    return result;
+}
+
+/* an unbiased random number from 0 to range - 1, range is from 1 to INT_MAX */
+static int rand_below(DECK_T *deck, int range)
+{
+    uint32_t    bound = (uint32_t)range;
+    uint64_t    mul = (rand_next(deck) >> 32) * bound;
+    uint32_t    low = (uint32_t)mul;
+    uint32_t    threshold = 0;
+
+    /* Lemire's method, reject the few products which would bias the result */
+    if (low < bound)
     {
-        case POKER_FROM_TOP: return deck->last_pile.top->card;
-        case POKER_FROM_BOTTOM: return deck->last_pile.bottom->card;
-        case POKER_FROM_INDEX:
-            card = deck->last_pile.top;
-            while (index-- > 0) card = card->next;
-            return card->card;
+        threshold = (0U - bound) % bound;
+        while (low < threshold)
+        {
+            mul = (rand_next(deck) >> 32) * bound;
+            low = (uint32_t)mul;
+        }
     }
-    return POKER_ERR;
+    return (int)(mul >> 32);
 }
 
-/* POKER_Show_TrashCard: show a card from trash_pile, 
-   * parameter: DECK_TP deck -- the pointer to a deck of poker
-                int type -- from top, bottom or index
-                int index -- from the index of last pile
-   * return value: card number for success, POKER_ERR for failure   */
-int POKER_Show_TrashCard(DECK_TP deck, int type, int index)
+static void seed_deck(DECK_T *deck, uint64_t seed)
 {
-    CARD_T *card = NULL;
+    int idx = 0;
 
-    if (deck == NULL) return POKER_ERR;
-    if (deck->trash_pile.card_num == 0) return POKER_ERR;
-    if (deck->trash_pile.card_num <= index) return POKER_ERR;
-    
-    switch (type)
+    for (idx = 0; idx < 4; idx++) deck->rand_state[idx] = splitmix64(&seed);
+}
+
+/* seed from OS entropy, or from the clock and the deck address if it can not be read */
+static void seed_entropy(DECK_T *deck)
+{
+    uint64_t        seed = 0;
+    struct timeval  tv;
+    int             fd = -1;
+
+    if ((fd = open("/dev/urandom", O_RDONLY)) >= 0)
     {
-        case POKER_FROM_TOP: return deck->trash_pile.top->card;
-        case POKER_FROM_BOTTOM: return deck->trash_pile.bottom->card;
-        case POKER_FROM_INDEX:
-            card = deck->trash_pile.top;
-            while (index-- > 0) card = card->next;
-            return card->card;
+        if (read(fd, &seed, sizeof(seed)) == sizeof(seed))
+        {
+            close(fd);
+            seed_deck(deck, seed);
+            return;
+        }
+        close(fd);
     }
-    return POKER_ERR;
+    gettimeofday(&tv, NULL);
+    seed = ((uint64_t)tv.tv_sec << 20) ^ (uint64_t)tv.tv_usec ^ (uint64_t)clock() ^ (uint64_t)(uintptr_t)deck;
+    seed_deck(deck, seed);
 }
 
-/* POKER_Show_PlayerCard: show a card from player_pile, 
-   * parameter: DECK_TP deck -- the pointer to a deck of poker
-                int player_no -- the player no
-                int type -- from top, bottom or index
-                int index -- from the index of last pile
-   * return value: card number for success, POKER_ERR for failure   */
-int POKER_Show_PlayerCard(DECK_TP deck, int player_no, int type, int index)
+/* put all cards into the empty last pile, priority is from spade A to club K */
+static void fill_deck(DECK_T *deck)
 {
-    CARD_T *card = NULL;
+    int color = 0;
+    int number = 0;
+    int joker = 0x01;
+    int pack = 0;
 
-    if (deck == NULL) return POKER_ERR;
-    if (deck->player == NULL) return POKER_ERR;
-    if (deck->player_num < player_no) return POKER_ERR;
-    if (deck->player[player_no-1].card_num == 0) return POKER_ERR;
-    if (deck->player[player_no-1].card_num <= index) return POKER_ERR;
-    
-    switch (type)
+    /* packs of a shoe follow one by one, the pack no is kept in the card */
+    for (pack = 0; pack < deck->pack_num; pack++)
     {
-        case POKER_FROM_TOP: return deck->player[player_no-1].top->card;
-        case POKER_FROM_BOTTOM: return deck->player[player_no-1].bottom->card;
-        case POKER_FROM_INDEX:
-            card = deck->player[player_no-1].top;
-            while (index-- > 0) card = card->next;
-            return card->card;
+        for (color = POKER_COLOR_SPADE; color >= POKER_COLOR_CLUB; color -= 0x10)
+        {
+            new_card(deck, POKER_PACK_CARD(pack, color | POKER_NUM_A));
+            for (number = POKER_NUM_2; number <= POKER_NUM_K; number += 0x01)
+                new_card(deck, POKER_PACK_CARD(pack, color | number));
+        }
+        for (joker = 0x01; joker <= deck->joker_num; joker += 0x01)
+            new_card(deck, POKER_PACK_CARD(pack, POKER_COLOR_JOKER | joker));
     }
-    return POKER_ERR;
 }
 
-/* POKER_Deal_Card: deal a card from last_pile to a player,
-   * parameter: DECK_TP deck -- the pointer to a deck of poker
-                int type -- from top, bottom or index of last_pile
-                int index -- from index of last_pile
-                int player_no -- the player no
-   * return value: POKER_OK for success, POKER_ERR for fail */
-int POKER_Deal_Card(DECK_TP deck, int type, int index, int player_no)
+/* how many packs of a deck in flag */
+static int pack_num(int flag)
 {
-    if (deck == NULL) return POKER_ERR;
-    if (deck->player == NULL) return POKER_ERR;
-    if (deck->player_num < player_no) return POKER_ERR;
-    if (deck->last_pile.card_num == 0) return POKER_ERR;
-    if (deck->last_pile.card_num <= index) return POKER_ERR;
+    int packs = (flag & POKER_DECK_PACK_MASK) >> 8;
 
-    return insert_card(&deck->player[player_no-1], remove_card(&deck->last_pile, type, index), POKER_FROM_BOTTOM);
+    return (packs == 0) ? 1 : packs;
 }
 
-/* POKER_Transfer_PlayerCard: transfer a card from a player to another,
-   * parameter: DECK_TP deck -- the pointer to a deck of poker
-                int type -- from top, bottom or index of last_pile
-                int index -- from index of last_pile
-                int from_player_no -- the player no
-                int to_player_no -- the player no
-   * return value: POKER_OK for success, POKER_ERR for fail */
-int POKER_Transfer_PlayerCard(DECK_TP deck, int type, int index, int from_player_no, int to_player_no)
+/* size of the memory block of a deck, 0 for invalid parameters
+   * layout: | DECK_T | PILE_T * players | int * total_num (scratch)
+                                         | CARD_T * total_num (list type)
+                                         | int * capacity * (players + 2) (array type) | */
+static size_t deck_size(int players, int joker_num, int flag)
 {
-    if (deck == NULL) return POKER_ERR;
-    if (deck->player == NULL) return POKER_ERR;
-    if (deck->player_num < from_player_no) return POKER_ERR;
-    if (deck->player_num < to_player_no) return POKER_ERR;
+    size_t  size = 0;
+    int     capacity = 0;
+    int     total = 0;
+
+    if ((joker_num < 0) || (joker_num > POKER_MASK_NUM) || (players < 0)) return 0;
+    if ((flag & ~(POKER_DECK_ARRAY | POKER_DECK_CARDSET | POKER_DECK_PACK_MASK)) != 0) return 0;
+    /* a card set has only 12 bits for jokers and no duplicate cards */
+    if ((flag & POKER_DECK_CARDSET) && (joker_num > POKER_CARDSET_JOKER)) return 0;
+    if ((flag & POKER_DECK_CARDSET) && (pack_num(flag) > 1)) return 0;
+
+    total = pack_num(flag) * (POKER_CARD_NUM + joker_num);
+    size = sizeof(DECK_T) + players * sizeof(PILE_T) + SCRATCH_SIZE(total);
+    if (flag & POKER_DECK_ARRAY)
+    {
+        /* every pile can hold the whole deck, capacity is power of 2 for masking */
+        for (capacity = 1; capacity < total; capacity <<= 1);
+        size += (size_t)capacity * (players + 2) * sizeof(int);
+    }
+    else
+    {
+        size += total * sizeof(CARD_T);
+    }
+    return size;
+}
+
+/* lay out a deck in a zeroed memory block and fill its last pile */
+static DECK_TP init_deck(void *mem, int players, int joker_num, int flag)
+{
+    DECK_TP deck = (DECK_T *)mem;
+    int     idx = 0;
+
+    deck->joker_num = joker_num;
+    deck->pack_num = pack_num(flag);
+    deck->total_num = deck->pack_num * (POKER_CARD_NUM + joker_num);
+    deck->player_num = players;
+    deck->type = flag & POKER_DECK_ARRAY;
+    deck->cardset = ((flag & POKER_DECK_CARDSET) != 0);
+    deck->player = (PILE_T *)(deck + 1);
+    deck->scratch = (int *)(deck->player + deck->player_num);
+
+    if (deck->type == POKER_DECK_ARRAY)
+    {
+        for (deck->mask = 1; deck->mask < deck->total_num; deck->mask <<= 1);
+        deck->last_pile.slot = (int *)((char *)deck->scratch + SCRATCH_SIZE(deck->total_num));
+        deck->trash_pile.slot = deck->last_pile.slot + deck->mask;
+        for (idx = 0; idx < deck->player_num; idx++)
+            deck->player[idx].slot = deck->trash_pile.slot + (idx + 1) * deck->mask;
+        deck->mask--;
+    }
+    else
+    {
+        deck->card = (CARD_T *)((char *)deck->scratch + SCRATCH_SIZE(deck->total_num));
+    }
+
+    fill_deck(deck);
+    return deck;
+}
+
+/* allocate a deck, its random number generator is not seeded */
+static DECK_TP create_deck(int players, int joker_num, int flag)
+{
+    DECK_TP deck = NULL;
+    void    *mem = NULL;
+    size_t  size = 0;
+
+    if ((size = deck_size(players, joker_num, flag)) == 0) return NULL;
+    if ((mem = calloc(1, size)) == NULL) return NULL;
+
+    deck = init_deck(mem, players, joker_num, flag);
+    deck->allocated = 1;
+    STAT_ADD(deck, allocs, 1);
+    return deck;
+}
+
+/* POKER_Create_Deck: create a deck of poker, priority is from spade A to club K
+   * paremeter: int players -- how many players
+                int joker_num -- how many joker cards
+   * return value: the pointer to a deck of poker */
+DECK_TP POKER_Create_Deck(int players, int joker_num)
+{
+    return POKER_Create_DeckEx(players, joker_num, POKER_DECK_LIST);
+}
+
+/* POKER_Create_DeckEx: create a deck of poker with the pile storage type
+   * paremeter: int players -- how many players
+                int joker_num -- how many joker cards
+                int flag -- POKER_DECK_LIST or POKER_DECK_ARRAY, or'ed with POKER_DECK_CARDSET or POKER_DECK_PACK(n)
+   * return value: the pointer to a deck of poker
+   * comment: POKER_Create_Deck creates a POKER_DECK_LIST deck, all POKER_* functions work on both types */
+DECK_TP POKER_Create_DeckEx(int players, int joker_num, int flag)
+{
+    DECK_TP deck = NULL;
+
+    if ((deck = create_deck(players, joker_num, flag)) != NULL) seed_entropy(deck);
+    return deck;
+}
+
+/* POKER_Get_DeckSize: get the memory size POKER_Init_Deck needs for a deck
+   * paremeter: int players -- how many players
+                int joker_num -- how many joker cards
+                int flag -- POKER_DECK_LIST or POKER_DECK_ARRAY, or'ed with POKER_DECK_CARDSET or POKER_DECK_PACK(n)
+   * return value: the size in bytes, 0 for invalid parameters */
+size_t POKER_Get_DeckSize(int players, int joker_num, int flag)
+{
+    return deck_size(players, joker_num, flag);
+}
+
+/* POKER_Init_Deck: create a deck of poker in a caller supplied memory block
+   * paremeter: void *mem -- the memory block, aligned for a pointer
+                size_t size -- the size of memory block
+                int players -- how many players
+                int joker_num -- how many joker cards
+                int flag -- POKER_DECK_LIST or POKER_DECK_ARRAY, or'ed with POKER_DECK_CARDSET or POKER_DECK_PACK(n)
+                unsigned long long seed -- the seed of random number generator, as POKER_Seed_Deck
+   * return value: the pointer to a deck of poker, NULL if the block is too small
+   * comment: POKER_Delete_Deck on this deck does not free the memory block, OS entropy is not read */
+DECK_TP POKER_Init_Deck(void *mem, size_t size, int players, int joker_num, int flag, unsigned long long seed)
+{
+    DECK_TP deck = NULL;
+    size_t  need = 0;
+
+    if (mem == NULL) return NULL;
+    if (((size_t)mem % sizeof(void *)) != 0) return NULL;
+    if ((need = deck_size(players, joker_num, flag)) == 0) return NULL;
+    if (size < need) return NULL;
+
+    memset(mem, 0, need);
+    deck = init_deck(mem, players, joker_num, flag);
+    seed_deck(deck, seed);
+    return deck;
+}
+
+/* POKER_Delete_Deck: delete a deck of poker */
+void POKER_Delete_Deck(DECK_TP *deck)
+{
+    if ((deck == NULL) || (*deck == NULL)) return;
+    
+    if ((*deck)->log != NULL) POKER_Close_Log(*deck);
+    if ((*deck)->allocated) free(*deck);
+    *deck = NULL;
+}
+
+static void clear_pile(PILE_T *pile)
+{
+    pile->top = pile->bottom = NULL;
+    pile->head = 0;
+    pile->card_num = 0;
+    pile->set = 0;
+}
+
+/* POKER_Reset_Deck: collect all cards back to last pile for a new game, no memory is allocated
+   * parameter: DECK_TP deck -- the pointer to a deck of poker
+                int shuffle -- 0 for priority from spade A to club K, otherwise shuffle last pile
+   * return value: POKER_OK for success, POKER_ERR for fail */
+int POKER_Reset_Deck(DECK_TP deck, int shuffle)
+{
+    int idx = 0;
+
+    if ((deck == NULL) || deck->cursor) return POKER_ERR;
+
+    clear_pile(&deck->last_pile);
+    clear_pile(&deck->trash_pile);
+    for (idx = 0; idx < deck->player_num; idx++)
+        clear_pile(&deck->player[idx]);
+    deck->cut_num = 0;
+    fill_deck(deck);
+    if (shuffle) shuffle_pile(deck, &deck->last_pile);
+    LOG_OP(deck, LOG_RESET, 1, shuffle ? 1 : 0);
+    return POKER_OK;
+}
+
+/* POKER_Seed_Deck: seed the random number generator of a deck, the same seed gives the same shuffles
+   * parameter: DECK_TP deck -- the pointer to a deck of poker
+                unsigned long long seed -- the seed
+   * return value: POKER_OK for success, POKER_ERR for fail */
+int POKER_Seed_Deck(DECK_TP deck, unsigned long long seed)
+{
+    if ((deck == NULL) || deck->cursor) return POKER_ERR;
+    seed_deck(deck, seed);
+    LOG_OP(deck, LOG_SEED, 4, (int)(seed & 0xFFFF), (int)((seed >> 16) & 0xFFFF),
+           (int)((seed >> 32) & 0xFFFF), (int)(seed >> 48));
+    return POKER_OK;
+}
+
+/* POKER_Seed_DeckRandom: seed the random number generator of a deck from OS entropy,
+   * parameter: DECK_TP deck -- the pointer to a deck of poker
+   * return value: POKER_OK for success, POKER_ERR for fail
+   * comment: a deck of POKER_Create_Deck or POKER_Create_DeckEx is already seeded this way */
+int POKER_Seed_DeckRandom(DECK_TP deck)
+{
+    if ((deck == NULL) || deck->cursor) return POKER_ERR;
+    seed_entropy(deck);
+    if (deck->log != NULL) log_snapshot(deck);
+    return POKER_OK;
+}
+
+/* POKER_Rand_Deck: get a random number from the random number generator of a deck
+   * parameter: DECK_TP deck -- the pointer to a deck of poker
+                int range -- the range of random number
+   * return value: an unbiased random number from 0 to range - 1, POKER_ERR for fail */
+int POKER_Rand_Deck(DECK_TP deck, int range)
+{
+    if ((deck == NULL) || deck->cursor) return POKER_ERR;
+    if (range <= 0) return POKER_ERR;
+    LOG_OP(deck, LOG_RAND, 2, range & 0xFFFF, range >> 16);
+    return rand_below(deck, range);
+}
+
+/* POKER_Copy_DeckRandom: copy the random number generator of a deck to another deck of any players,
+   * parameter: DECK_TP to -- the pointer to a deck of poker
+                DECK_TP from -- the pointer to a deck of poker, not changed
+   * return value: POKER_OK for success, POKER_ERR for fail
+   * comment: random numbers of to are those from would give next */
+int POKER_Copy_DeckRandom(DECK_TP to, DECK_TP from)
+{
+    if ((to == NULL) || (from == NULL) || to->cursor || from->cursor) return POKER_ERR;
+    memcpy(to->rand_state, from->rand_state, sizeof(to->rand_state));
+    if (to->log != NULL) log_snapshot(to);
+    return POKER_OK;
+}
+
+/* POKER_Set_CutCard: put the cut card into last pile, for a shoe to know when to reshuffle
+   * parameter: DECK_TP deck -- the pointer to a deck of poker
+                int index -- the cut card is in front of the card of index, 0 ~ card number of last pile
+   * return value: POKER_OK for success, POKER_ERR for fail
+   * comment: the cut card stays in place while cards are dealt from top, POKER_Reset_Deck puts it to the bottom */
+int POKER_Set_CutCard(DECK_TP deck, int index)
+{
+    if ((deck == NULL) || deck->cursor) return POKER_ERR;
+    if ((index < 0) || (index > deck->last_pile.card_num)) return POKER_ERR;
+    deck->cut_num = deck->last_pile.card_num - index;
+    LOG_OP(deck, LOG_CUT, 1, index);
+    return POKER_OK;
+}
+
+/* POKER_Check_CutCard: check if the cut card is reached
+   * parameter: DECK_TP deck -- the pointer to a deck of poker
+   * return value: POKER_OK for reached, POKER_NONE for not yet, POKER_ERR for failure */
+int POKER_Check_CutCard(DECK_TP deck)
+{
+    if ((deck == NULL) || deck->cursor) return POKER_ERR;
+    return (deck->last_pile.card_num <= deck->cut_num) ? POKER_OK : POKER_NONE;
+}
+
+/* POKER_Get_TotalCardNum: get total card number,
+   * parameter: DECK_TP deck -- the pointer to a deck of poker
+   * return value: the total card number    */
+int POKER_Get_TotalCardNum(DECK_TP deck)
+{
+    if ((deck == NULL) || deck->cursor) return POKER_ERR;
+    return deck->total_num;
+}
+
+/* POKER_Get_LastCardNum: get card number of last pile,
+   * parameter: DECK_TP deck -- the pointer to a deck of poker
+   * return value: the card number of last pile  */
+int POKER_Get_LastCardNum(DECK_TP deck)
+{
+    if ((deck == NULL) || deck->cursor) return POKER_ERR;
+    return deck->last_pile.card_num;
+}
+
+/* POKER_Get_TrashCardNum: get card number of trash pile,
+   * parameter: DECK_TP deck -- the pointer to a deck of poker
+   * return value: the card number of trash pile  */
+int POKER_Get_TrashCardNum(DECK_TP deck)
+{
+    if ((deck == NULL) || deck->cursor) return POKER_ERR;
+    return deck->trash_pile.card_num;
+}
+
+/* POKER_Get_PlayerNum: get card number of player pile,
+   * parameter: DECK_TP deck -- the pointer to a deck of poker
+                int player_no -- the player_no
+   * return value: the card number of player pile  */
+int POKER_Get_PlayerCardNum(DECK_TP deck, int player_no)
+{
+    if ((deck == NULL) || deck->cursor) return POKER_ERR;
+    if (deck->player == NULL) return POKER_ERR;
+    if ((player_no < 1) || (deck->player_num < player_no)) return POKER_ERR;
+    return deck->player[player_no-1].card_num;
+}
+
+/* POKER_Show_LastCard: show a card from last_pile, 
+   * parameter: DECK_TP deck -- the pointer to a deck of poker
+                int type -- from top, bottom or index
+                int index -- from the index of last pile
+   * return value: card number for success, POKER_ERR for failure   */
+int POKER_Show_LastCard(DECK_TP deck, int type, int index)
+{
+    int rv = POKER_ERR;
+
+    if ((deck == NULL) || deck->cursor) return POKER_ERR;
+    if (deck->last_pile.card_num == 0) return POKER_ERR;
+    if (deck->last_pile.card_num <= index) return POKER_ERR;
+
+    STAT_TIME(deck, POKER_STAT_SHOW, rv = peek_card(deck, &deck->last_pile, type, index));
+    return rv;
+}
+
+/* POKER_Show_TrashCard: show a card from trash_pile, 
+   * parameter: DECK_TP deck -- the pointer to a deck of poker
+                int type -- from top, bottom or index
+                int index -- from the index of last pile
+   * return value: card number for success, POKER_ERR for failure   */
+int POKER_Show_TrashCard(DECK_TP deck, int type, int index)
+{
+    int rv = POKER_ERR;
+
+    if ((deck == NULL) || deck->cursor) return POKER_ERR;
+    if (deck->trash_pile.card_num == 0) return POKER_ERR;
+    if (deck->trash_pile.card_num <= index) return POKER_ERR;
+
+    STAT_TIME(deck, POKER_STAT_SHOW, rv = peek_card(deck, &deck->trash_pile, type, index));
+    return rv;
+}
+
+/* POKER_Show_PlayerCard: show a card from player_pile, 
+   * parameter: DECK_TP deck -- the pointer to a deck of poker
+                int player_no -- the player no
+                int type -- from top, bottom or index
+                int index -- from the index of last pile
+   * return value: card number for success, POKER_ERR for failure   */
+int POKER_Show_PlayerCard(DECK_TP deck, int player_no, int type, int index)
+{
+    int rv = POKER_ERR;
+
+    if ((deck == NULL) || deck->cursor) return POKER_ERR;
+    if (deck->player == NULL) return POKER_ERR;
+    if ((player_no < 1) || (deck->player_num < player_no)) return POKER_ERR;
+    if (deck->player[player_no-1].card_num == 0) return POKER_ERR;
+    if (deck->player[player_no-1].card_num <= index) return POKER_ERR;
+
+    STAT_TIME(deck, POKER_STAT_SHOW, rv = peek_card(deck, &deck->player[player_no-1], type, index));
+    return rv;
+}
+
+/* POKER_Deal_Card: deal a card from last_pile to a player,
+   * parameter: DECK_TP deck -- the pointer to a deck of poker
+                int type -- from top, bottom or index of last_pile
+                int index -- from index of last_pile
+                int player_no -- the player no
+   * return value: POKER_OK for success, POKER_ERR for fail */
+int POKER_Deal_Card(DECK_TP deck, int type, int index, int player_no)
+{
+    int rv = POKER_ERR;
+
+    if ((deck == NULL) || deck->cursor) return POKER_ERR;
+    if (deck->player == NULL) return POKER_ERR;
+    if ((player_no < 1) || (deck->player_num < player_no)) return POKER_ERR;
+    if (deck->last_pile.card_num == 0) return POKER_ERR;
+    if (deck->last_pile.card_num <= index) return POKER_ERR;
+
+    STAT_TIME(deck, POKER_STAT_DEAL,
+              rv = pass_card(deck, &deck->last_pile, type, index, &deck->player[player_no-1], POKER_FROM_BOTTOM));
+    if (rv == POKER_OK) LOG_OP(deck, LOG_DEAL_CARD, 3, type, LOG_INDEX(type, index), player_no);
+    return rv;
+}
+
+/* deal total cards from top of last pile one by one to players, from first_player in turn of
+   players players, parameters are checked by caller */
+static void deal_top(DECK_T *deck, int first_player, int players, int total)
+{
+    PILE_T  *last = &deck->last_pile;
+    PILE_T  *pile = NULL;
+    CARD_T  *card = NULL;
+    int     value = 0;
+    int     player = first_player - 1;
+    int     turn = 0;
+    int     idx = 0;
+
+    deck->cut_num -= cut_behind(deck, last, 0, total);
+    for (idx = 0; idx < total; idx++)
+    {
+        pile = &deck->player[player];
+        if (deck->type == POKER_DECK_ARRAY)
+        {
+            value = SLOT(deck, last, idx);
+            SLOT(deck, pile, pile->card_num) = value;
+            pile->card_num++;
+        }
+        else
+        {
+            card = last->top;
+            unlink_card(last, card);
+            insert_card(pile, card, POKER_FROM_BOTTOM);
+            value = card->card;
+        }
+        if (deck->cardset)
+        {
+            last->set &= ~POKER_Card_Bit(value);
+            pile->set |= POKER_Card_Bit(value);
+        }
+        /* next player in turn */
+        if (++turn == players)
+        {
+            turn = 0;
+            player = first_player - 1;
+        }
+        else if (++player == deck->player_num) player = 0;
+    }
+    if (deck->type == POKER_DECK_ARRAY)
+    {
+        last->head = (last->head + total) & deck->mask;
+        last->card_num -= total;
+    }
+}
+
+/* POKER_Deal_Cards: deal cards from top of last_pile to a player,
+   * parameter: DECK_TP deck -- the pointer to a deck of poker
+                int num -- how many cards
+                int player_no -- the player no
+   * return value: POKER_OK for success, POKER_ERR for fail, no card is dealt if fail */
+int POKER_Deal_Cards(DECK_TP deck, int num, int player_no)
+{
+    if ((deck == NULL) || deck->cursor) return POKER_ERR;
+    if ((player_no < 1) || (deck->player_num < player_no)) return POKER_ERR;
+    if ((num < 0) || (deck->last_pile.card_num < num)) return POKER_ERR;
+
+    STAT_TIME(deck, POKER_STAT_DEAL, deal_top(deck, player_no, 1, num));
+    LOG_OP(deck, LOG_DEAL_CARDS, 2, num, player_no);
+    return POKER_OK;
+}
+
+/* POKER_Deal_Round: deal cards from top of last_pile to every player in turn,
+   * parameter: DECK_TP deck -- the pointer to a deck of poker
+                int num -- how many cards for every player
+                int first_player -- the player no who gets the first card
+   * return value: POKER_OK for success, POKER_ERR for fail, no card is dealt if fail */
+int POKER_Deal_Round(DECK_TP deck, int num, int first_player)
+{
+    if ((deck == NULL) || deck->cursor) return POKER_ERR;
+    if ((first_player < 1) || (deck->player_num < first_player)) return POKER_ERR;
+    if ((num < 0) || (num > deck->last_pile.card_num / deck->player_num)) return POKER_ERR;
+
+    STAT_TIME(deck, POKER_STAT_DEAL, deal_top(deck, first_player, deck->player_num, num * deck->player_num));
+    LOG_OP(deck, LOG_DEAL_ROUND, 2, num, first_player);
+    return POKER_OK;
+}
+
+/* POKER_Deal_All: deal all cards of last_pile to every player in turn,
+   * parameter: DECK_TP deck -- the pointer to a deck of poker
+                int first_player -- the player no who gets the first card
+   * return value: POKER_OK for success, POKER_ERR for fail */
+int POKER_Deal_All(DECK_TP deck, int first_player)
+{
+    if ((deck == NULL) || deck->cursor) return POKER_ERR;
+    if ((first_player < 1) || (deck->player_num < first_player)) return POKER_ERR;
+
+    STAT_TIME(deck, POKER_STAT_DEAL, deal_top(deck, first_player, deck->player_num, deck->last_pile.card_num));
+    LOG_OP(deck, LOG_DEAL_ALL, 1, first_player);
+    return POKER_OK;
+}
+
+/* POKER_Transfer_PlayerCard: transfer a card from a player to another,
+   * parameter: DECK_TP deck -- the pointer to a deck of poker
+                int type -- from top, bottom or index of last_pile
+                int index -- from index of last_pile
+                int from_player_no -- the player no
+                int to_player_no -- the player no
+   * return value: POKER_OK for success, POKER_ERR for fail */
+int POKER_Transfer_PlayerCard(DECK_TP deck, int type, int index, int from_player_no, int to_player_no)
+{
+    int rv = POKER_ERR;
+
+    if ((deck == NULL) || deck->cursor) return POKER_ERR;
+    if (deck->player == NULL) return POKER_ERR;
+    if ((from_player_no < 1) || (deck->player_num < from_player_no)) return POKER_ERR;
+    if ((to_player_no < 1) || (deck->player_num < to_player_no)) return POKER_ERR;
     if (deck->player[from_player_no-1].card_num == 0) return POKER_ERR;
 
-    return insert_card(&deck->player[to_player_no-1], 
-                       remove_card(&deck->player[from_player_no-1], type, index), 
-                       POKER_FROM_BOTTOM);
+    STAT_TIME(deck, POKER_STAT_TRANSFER, rv = pass_card(deck, &deck->player[from_player_no-1], type, index,
+                                                        &deck->player[to_player_no-1], POKER_FROM_BOTTOM));
+    if (rv == POKER_OK) LOG_OP(deck, LOG_TRANSFER, 4, type, LOG_INDEX(type, index), from_player_no, to_player_no);
+    return rv;
 }
 
 /* POKER_Throw_LastCard: throw a card from last_pile to trash_pile,
    * parameter: DECK_TP deck -- the pointer to a deck of poker
-                int type -- from top, bottom or index of last_pile
-                int index -- from index of last_pile
+                int type -- from top, bottom or index of last_pile
+                int index -- from index of last_pile
+   * return value: POKER_OK for success, POKER_ERR for fail */
+int POKER_Throw_LastCard(DECK_TP deck, int type, int index)
+{
+    int rv = POKER_ERR;
+
+    if ((deck == NULL) || deck->cursor) return POKER_ERR;
+    if (deck->last_pile.card_num == 0) return POKER_ERR;
+    if (deck->last_pile.card_num <= index) return POKER_ERR;
+    if (deck->trash_pile.card_num == deck->total_num) return POKER_ERR;
+    
+    STAT_TIME(deck, POKER_STAT_THROW,
+              rv = pass_card(deck, &deck->last_pile, type, index, &deck->trash_pile, POKER_FROM_BOTTOM));
+    if (rv == POKER_OK) LOG_OP(deck, LOG_THROW_LAST, 2, type, LOG_INDEX(type, index));
+    return rv;
+}
+
+/* POKER_Throw_PlayerCard: throw a card from player to trash_pile,
+   * parameter: DECK_TP deck -- the pointer to a deck of poker
+                int player_no -- the player no
+                int type -- from top, bottom or index of player's pile
+                int index -- the index of player's pile
+   * return value: POKER_OK for success, POKER_ERR for fail */
+int POKER_Throw_PlayerCard(DECK_TP deck, int player_no, int type, int index)
+{
+    int rv = POKER_ERR;
+
+    if ((deck == NULL) || deck->cursor) return POKER_ERR;
+    if (deck->player == NULL) return POKER_ERR;
+    if ((player_no < 1) || (deck->player_num < player_no)) return POKER_ERR;
+    if (deck->player[player_no-1].card_num <= index) return POKER_ERR;
+    if (deck->trash_pile.card_num == deck->total_num) return POKER_ERR;
+    
+    STAT_TIME(deck, POKER_STAT_THROW,
+              rv = pass_card(deck, &deck->player[player_no-1], type, index, &deck->trash_pile, POKER_FROM_BOTTOM));
+    if (rv == POKER_OK) LOG_OP(deck, LOG_THROW_PLAYER, 3, player_no, type, LOG_INDEX(type, index));
+    return rv;
+}
+
+/* throw the pairs of the same number from a pile to trash pile, the last card of an odd count stays */
+static int throw_pair(DECK_T *deck, PILE_T *pile, int *cards, int max)
+{
+    int     count[POKER_MASK_NUM + 1];
+    int     thrown = 0;
+    int     idx = 0;
+    int     keep = 0;
+    int     value = 0;
+    CARD_T  *card = NULL;
+    CARD_T  *next = NULL;
+
+    /* count every number, jokers are not paired */
+    memset(count, 0, sizeof(count));
+    if (deck->type == POKER_DECK_ARRAY)
+    {
+        for (idx = 0; idx < pile->card_num; idx++)
+        {
+            value = SLOT(deck, pile, idx);
+            if (POKER_Color(value) != POKER_COLOR_JOKER) count[POKER_Num(value)]++;
+        }
+    }
+    else
+    {
+        for (card = pile->top; card != NULL; card = card->next)
+            if (POKER_Color(card->card) != POKER_COLOR_JOKER) count[POKER_Num(card->card)]++;
+    }
+    for (idx = 0; idx <= POKER_MASK_NUM; idx++) count[idx] &= ~1;
+
+    /* throw the first even count of cards of every number */
+    if (deck->type == POKER_DECK_ARRAY)
+    {
+        for (idx = 0; idx < pile->card_num; idx++)
+        {
+            value = SLOT(deck, pile, idx);
+            if ((POKER_Color(value) == POKER_COLOR_JOKER) || (count[POKER_Num(value)] == 0))
+            {
+                SLOT(deck, pile, keep++) = value;
+                continue;
+            }
+            count[POKER_Num(value)]--;
+            array_insert(deck, &deck->trash_pile, value, POKER_FROM_BOTTOM);
+            if (deck->cardset)
+            {
+                pile->set &= ~POKER_Card_Bit(value);
+                deck->trash_pile.set |= POKER_Card_Bit(value);
+            }
+            if (thrown < max) cards[thrown] = value;
+            thrown++;
+        }
+        pile->card_num = keep;
+    }
+    else
+    {
+        for (card = pile->top; card != NULL; card = next)
+        {
+            next = card->next;
+            value = card->card;
+            if ((POKER_Color(value) == POKER_COLOR_JOKER) || (count[POKER_Num(value)] == 0)) continue;
+            count[POKER_Num(value)]--;
+            unlink_card(pile, card);
+            insert_card(&deck->trash_pile, card, POKER_FROM_BOTTOM);
+            if (deck->cardset)
+            {
+                pile->set &= ~POKER_Card_Bit(value);
+                deck->trash_pile.set |= POKER_Card_Bit(value);
+            }
+            if (thrown < max) cards[thrown] = value;
+            thrown++;
+        }
+    }
+    return thrown;
+}
+
+#define SORT_KEY_NUM    160  /* keys of standard orders are 0 ~ SORT_KEY_NUM - 1 */
+#define SORT_RUN        16   /* runs shorter than this are insertion sorted */
+
+/* the order of a color, spade first and joker last */
+#define COLOR_ORDER(card)  ((POKER_COLOR_SPADE - POKER_Color(card)) >> 4)
+
+/* key of a card in standard orders, cards are sorted by ascending key */
+static int sort_key(int (*comp_func)(int card1, int card2), int card)
+{
+    int num = POKER_Num(card);
+
+    if (POKER_Color(card) == POKER_COLOR_JOKER)
+    {
+        /* jokers are behind all other cards */
+        if ((comp_func == POKER_Comp_ColorNum) || (comp_func == POKER_Comp_ColorNumAceHigh)) return 4 * 16 + num;
+        return 16 * 8 + num;
+    }
+    if ((comp_func == POKER_Comp_ColorNum) || (comp_func == POKER_Comp_NumColor))
+        num = (num == POKER_NUM_A) ? 0 : (num - 1);
+    else
+        num -= POKER_NUM_2;
+    if ((comp_func == POKER_Comp_ColorNum) || (comp_func == POKER_Comp_ColorNumAceHigh))
+        return COLOR_ORDER(card) * 16 + num;
+    return num * 8 + COLOR_ORDER(card);
+}
+
+static int is_standard_order(int (*comp_func)(int card1, int card2))
+{
+    return (comp_func == POKER_Comp_ColorNum) || (comp_func == POKER_Comp_ColorNumAceHigh) ||
+           (comp_func == POKER_Comp_NumColor) || (comp_func == POKER_Comp_NumColorAceHigh);
+}
+
+/* stable merge sort of cards, buf is working space of the same size */
+static void merge_sort(DECK_T *deck, int *cards, int *buf, int total, int (*comp_func)(int card1, int card2))
+{
+    int half = total / 2;
+    int left = 0;
+    int right = half;
+    int idx = 0;
+    int card = 0;
+
+    if (total <= SORT_RUN)
+    {
+        for (left = 1; left < total; left++)
+        {
+            card = cards[left];
+            for (idx = left; (idx > 0) && (COMPARE(deck, comp_func, cards[idx - 1], card) > 0); idx--) cards[idx] = cards[idx - 1];
+            cards[idx] = card;
+        }
+        return;
+    }
+    merge_sort(deck, cards, buf, half, comp_func);
+    merge_sort(deck, cards + half, buf + half, total - half, comp_func);
+    /* already in order */
+    if (COMPARE(deck, comp_func, cards[half - 1], cards[half]) <= 0) return;
+
+    memcpy(buf, cards, total * sizeof(int));
+    while ((left < half) && (right < total))
+    {
+        /* take the left one for the same cards to keep stable */
+        if (COMPARE(deck, comp_func, buf[left], buf[right]) <= 0) cards[idx++] = buf[left++];
+        else cards[idx++] = buf[right++];
+    }
+    while (left < half) cards[idx++] = buf[left++];
+    while (right < total) cards[idx++] = buf[right++];
+}
+
+/* stable merge sort of a list */
+static void list_merge_sort(DECK_T *deck, PILE_T *pile, int (*comp_func)(int card1, int card2))
+{
+    CARD_T  *list = pile->top;
+    CARD_T  *head = NULL;
+    CARD_T  **tail = NULL;
+    CARD_T  *left = NULL;
+    CARD_T  *right = NULL;
+    CARD_T  *next = NULL;
+    int     width = 0;
+    int     merges = 0;
+    int     left_num = 0;
+    int     right_num = 0;
+
+    /* bottom-up merge of runs of width on next links */
+    for (width = 1; ; width <<= 1)
+    {
+        head = NULL;
+        tail = &head;
+        merges = 0;
+        left = list;
+        while (left != NULL)
+        {
+            merges++;
+            right = left;
+            for (left_num = 0; (left_num < width) && (right != NULL); left_num++) right = right->next;
+            right_num = width;
+            while ((left_num > 0) || ((right_num > 0) && (right != NULL)))
+            {
+                if ((left_num == 0) || ((right_num > 0) && (right != NULL) && (COMPARE(deck, comp_func, left->card, right->card) > 0)))
+                {
+                    next = right;
+                    right = right->next;
+                    right_num--;
+                }
+                else
+                {
+                    next = left;
+                    left = left->next;
+                    left_num--;
+                }
+                *tail = next;
+                tail = &next->next;
+            }
+            left = right;
+        }
+        *tail = NULL;
+        list = head;
+        if (merges <= 1) break;
+    }
+
+    /* fix prev links */
+    pile->top = list;
+    for (next = NULL, left = list; left != NULL; next = left, left = left->next) left->prev = next;
+    pile->bottom = next;
+}
+
+/* stable counting sort for standard orders */
+static void array_counting_sort(int *cards, int *sorted, int total, int (*comp_func)(int card1, int card2))
+{
+    int count[SORT_KEY_NUM + 1];
+    int idx = 0;
+
+    memset(count, 0, sizeof(count));
+    for (idx = 0; idx < total; idx++) count[sort_key(comp_func, cards[idx]) + 1]++;
+    for (idx = 1; idx <= SORT_KEY_NUM; idx++) count[idx] += count[idx - 1];
+    for (idx = 0; idx < total; idx++) sorted[count[sort_key(comp_func, cards[idx])]++] = cards[idx];
+}
+
+/* stable bucket sort of a list for standard orders */
+static void list_bucket_sort(PILE_T *pile, int (*comp_func)(int card1, int card2))
+{
+    CARD_T  *head[SORT_KEY_NUM];
+    CARD_T  *tail[SORT_KEY_NUM];
+    CARD_T  *card = NULL;
+    CARD_T  *next = NULL;
+    int     key = 0;
+
+    memset(head, 0, sizeof(head));
+    for (card = pile->top; card != NULL; card = next)
+    {
+        next = card->next;
+        key = sort_key(comp_func, card->card);
+        card->next = NULL;
+        if (head[key] == NULL) head[key] = card;
+        else tail[key]->next = card;
+        tail[key] = card;
+    }
+    pile->top = pile->bottom = NULL;
+    for (key = 0; key < SORT_KEY_NUM; key++)
+    {
+        if (head[key] == NULL) continue;
+        if (pile->top == NULL) pile->top = head[key];
+        else pile->bottom->next = head[key];
+        pile->bottom = tail[key];
+    }
+    for (next = NULL, card = pile->top; card != NULL; next = card, card = card->next) card->prev = next;
+}
+
+static void sort_pile(DECK_T *deck, PILE_T *pile, int (*comp_func)(int card1, int card2))
+{
+    int idx = 0;
+
+    if (deck->type != POKER_DECK_ARRAY)
+    {
+        if (is_standard_order(comp_func)) list_bucket_sort(pile, comp_func);
+        else list_merge_sort(deck, pile, comp_func);
+        return;
+    }
+
+    /* lay the ring out in scratch, the slots are free as working space then */
+    for (idx = 0; idx < pile->card_num; idx++) deck->scratch[idx] = SLOT(deck, pile, idx);
+    pile->head = 0;
+    if (is_standard_order(comp_func))
+    {
+        array_counting_sort(deck->scratch, pile->slot, pile->card_num, comp_func);
+        return;
+    }
+    merge_sort(deck, deck->scratch, pile->slot, pile->card_num, comp_func);
+    memcpy(pile->slot, deck->scratch, pile->card_num * sizeof(int));
+}
+
+static void dump_pile(DECK_T *deck, PILE_T *pile, void (*dump_func)(int index, int card, void *para), void *para)
+{
+    int     idx = 0;
+    CARD_T  *tmp = NULL;
+
+    if (deck->type == POKER_DECK_ARRAY)
+    {
+        for (idx = 0; idx < pile->card_num; idx++) dump_func(idx, SLOT(deck, pile, idx), para);
+        return;
+    }
+    for (tmp = pile->top; tmp != NULL; tmp = tmp->next)
+    {
+        dump_func(idx++, tmp->card, para);
+    }
+}
+
+static int search_pile(DECK_T *deck, PILE_T *pile, int (*search_func)(int index, int card, void *para), void *para)
+{
+    int     idx = 0;
+    CARD_T  *tmp = NULL;
+
+    if (deck->type == POKER_DECK_ARRAY)
+    {
+        for (idx = 0; idx < pile->card_num; idx++)
+        {
+            STAT_ADD(deck, callbacks, 1);
+            if (search_func(idx, SLOT(deck, pile, idx), para) == POKER_OK) return POKER_OK;
+        }
+        return POKER_NONE;
+    }
+    for (tmp = pile->top; tmp != NULL; tmp = tmp->next)
+    {
+        STAT_ADD(deck, callbacks, 1);
+        if (search_func(idx++, tmp->card, para) == POKER_OK) return POKER_OK;
+    }
+    return POKER_NONE;
+}
+
+/* POKER_Throw_PlayerPair: throw all pairs of the same number from player to trash_pile,
+   * parameter: DECK_TP deck -- the pointer to a deck of poker
+                int player_no -- the player no
+                int *cards -- the thrown cards in order, could be NULL
+                int max -- the size of cards
+   * return value: the number of thrown cards, POKER_ERR for fail
+   * comment: cards are paired from top of pile, the last card of an odd count is kept, jokers are not paired */
+int POKER_Throw_PlayerPair(DECK_TP deck, int player_no, int *cards, int max)
+{
+    int rv = POKER_ERR;
+
+    if ((deck == NULL) || deck->cursor) return POKER_ERR;
+    if (deck->player == NULL) return POKER_ERR;
+    if ((player_no < 1) || (deck->player_num < player_no)) return POKER_ERR;
+    if (cards == NULL) max = 0;
+
+    STAT_TIME(deck, POKER_STAT_THROW, rv = throw_pair(deck, &deck->player[player_no-1], cards, max));
+    LOG_OP(deck, LOG_THROW_PAIR, 1, player_no);
+    return rv;
+}
+
+/* POKER_Move_Pile: move all cards of a pile onto another pile,
+   * parameter: DECK_TP deck -- the pointer to a deck of poker
+                int from_pile_no -- the player no, POKER_PILE_LAST or POKER_PILE_TRASH
+                int to_pile_no -- the player no, POKER_PILE_LAST or POKER_PILE_TRASH
+                int type -- onto top or bottom of to_pile
+   * return value: POKER_OK for success, POKER_ERR for fail
+   * comment: the order of cards is kept, it takes O(1) for list type */
+int POKER_Move_Pile(DECK_TP deck, int from_pile_no, int to_pile_no, int type)
+{
+    PILE_T *from = NULL;
+
+    if ((deck == NULL) || deck->cursor) return POKER_ERR;
+    if ((from = get_pile(deck, from_pile_no)) == NULL) return POKER_ERR;
+    return POKER_Move_PileRange(deck, from_pile_no, 0, from->card_num, to_pile_no, type);
+}
+
+/* POKER_Move_PileRange: move cards of index ~ index + num - 1 of a pile onto another pile,
+   * parameter: DECK_TP deck -- the pointer to a deck of poker
+                int from_pile_no -- the player no, POKER_PILE_LAST or POKER_PILE_TRASH
+                int index -- the index of first card
+                int num -- how many cards
+                int to_pile_no -- the player no, POKER_PILE_LAST or POKER_PILE_TRASH
+                int type -- onto top or bottom of to_pile
+   * return value: POKER_OK for success, POKER_ERR for fail
+   * comment: the order of cards is kept */
+int POKER_Move_PileRange(DECK_TP deck, int from_pile_no, int index, int num, int to_pile_no, int type)
+{
+    PILE_T *from = NULL;
+    PILE_T *to = NULL;
+
+    if ((deck == NULL) || deck->cursor) return POKER_ERR;
+    if ((from = get_pile(deck, from_pile_no)) == NULL) return POKER_ERR;
+    if ((to = get_pile(deck, to_pile_no)) == NULL) return POKER_ERR;
+    if (from == to) return POKER_ERR;
+    if ((type != POKER_FROM_TOP) && (type != POKER_FROM_BOTTOM)) return POKER_ERR;
+    if ((index < 0) || (num < 0) || (index + num > from->card_num)) return POKER_ERR;
+
+    STAT_TIME(deck, POKER_STAT_MOVE, splice_pile(deck, from, index, num, to, type));
+    LOG_OP(deck, LOG_MOVE, 5, from_pile_no, index, num, to_pile_no, type);
+    return POKER_OK;
+}
+
+/* POKER_Dump_PlayerPile: dump a player's pile, the way appointed in dump_func
+   * parameter: DECK_TP deck -- the pointer to a deck of poker
+                int player_no -- the player no.
+                void (*dump_func)(int index, int card, void *para) -- the dump rule function,
+                void *para -- user parameter */
+void POKER_Dump_PlayerPile(DECK_TP deck, int player_no, void (*dump_func)(int index, int card, void *para), void *para)
+{
+    if ((deck == NULL) || deck->cursor) return;
+    if (deck->player == NULL) return;
+    if ((player_no < 1) || (deck->player_num < player_no)) return;
+    dump_pile(deck, &deck->player[player_no-1], dump_func, para);
+}
+
+/* POKER_Dump_LastPile: dump last pile, the way appointed in dump_func
+   * parameter: DECK_TP deck -- the pointer to a deck of poker
+                void (*dump_func)(int index, int card, void *para) -- the dump rule function,
+                void *para -- user parameter */
+void POKER_Dump_LastPile(DECK_TP deck, void (*dump_func)(int index, int card, void *para), void *para)
+{
+    if ((deck == NULL) || deck->cursor) return;
+    dump_pile(deck, &deck->last_pile, dump_func, para);
+}
+
+/* POKER_Dump_TrashPile: dump trash pile, the way appointed in dump_func
+   * parameter: DECK_TP deck -- the pointer to a deck of poker
+                void (*dump_func)(int index, int card, void *para) -- the dump rule function,
+                void *para -- user parameter */
+void POKER_Dump_TrashPile(DECK_TP deck, void (*dump_func)(int index, int card, void *para), void *para)
+{
+    if ((deck == NULL) || deck->cursor) return;
+    dump_pile(deck, &deck->trash_pile, dump_func, para);
+}
+
+/* POKER_Search_PlayerPile: search from player's pile, the way appointed in search_func
+   * parameter: DECK_TP deck -- the pointer to a deck of poker
+                int player_no -- the player no.
+                int (*search_func)(int index, int card, void *para) -- the search rule function,
+                void *para -- user parameter
+   * return value: POKER_OK for found, POKER_NONE for none, POKER_ERR for failure
+   * comment: if the search func return POKER_OK, means found and function will return, else keep loop searching    */
+int POKER_Search_PlayerPile(DECK_TP deck, int player_no, 
+                            int (*search_func)(int index, int card, void *para), void *para)
+{
+    int rv = POKER_ERR;
+
+    if ((deck == NULL) || deck->cursor) return POKER_ERR;
+    if (deck->player == NULL) return POKER_ERR;
+    if ((player_no < 1) || (deck->player_num < player_no)) return POKER_ERR;
+    STAT_TIME(deck, POKER_STAT_SEARCH, rv = search_pile(deck, &deck->player[player_no-1], search_func, para));
+    return rv;
+}
+
+/* POKER_Search_LastPile: search from last pile, the way appointed in search_func
+   * parameter: DECK_TP deck -- the pointer to a deck of poker
+                int (*search_func)(int index, int card, void *para) -- the dump rule function,
+                void *para -- user parameter
+   * return value: POKER_OK for found, POKER_NONE for none, POKER_ERR for failure
+   * comment: if the search func return POKER_OK, means found and function will return, else keep loop searching    */
+int POKER_Search_LastPile(DECK_TP deck, int (*search_func)(int index, int card, void *para), void *para)
+{
+    int rv = POKER_ERR;
+
+    if ((deck == NULL) || deck->cursor) return POKER_ERR;
+    STAT_TIME(deck, POKER_STAT_SEARCH, rv = search_pile(deck, &deck->last_pile, search_func, para));
+    return rv;
+}
+
+/* POKER_Search_TrashPile: search trash pile, the way appointed in search_func
+   * parameter: DECK_TP deck -- the pointer to a deck of poker
+                int (*search_func)(int index, int card, void *para) -- the dump rule function,
+                void *para -- user parameter
+   * return value: POKER_OK for found, POKER_NONE for none, POKER_ERR for failure
+   * comment: if the search func return POKER_OK, means found and function will return, else keep loop searching    */
+int POKER_Search_TrashPile(DECK_TP deck, int (*search_func)(int index, int card, void *para), void *para)
+{
+    int rv = POKER_ERR;
+
+    if ((deck == NULL) || deck->cursor) return POKER_ERR;
+    STAT_TIME(deck, POKER_STAT_SEARCH, rv = search_pile(deck, &deck->trash_pile, search_func, para));
+    return rv;
+}
+
+/* POKER_Begin_Cursor: start a cursor at the top card of a pile,
+   * parameter: DECK_TP deck -- the pointer to a deck of poker
+                int pile_no -- the player no, POKER_PILE_LAST or POKER_PILE_TRASH
+                CURSOR_T *cursor -- the cursor
+   * return value: the top card, POKER_NONE for an empty pile, POKER_ERR for fail
+   * comment: a deck has one cursor at most, till POKER_End_Cursor the deck is changed only by the cursor and
+              every other call on the deck fails, POKER_Delete_Deck excepted */
+int POKER_Begin_Cursor(DECK_TP deck, int pile_no, CURSOR_T *cursor)
+{
+    PILE_T *pile = NULL;
+
+    if ((deck == NULL) || deck->cursor || (cursor == NULL)) return POKER_ERR;
+    if ((pile = get_pile(deck, pile_no)) == NULL) return POKER_ERR;
+
+    deck->cursor = 1;
+    cursor->deck = deck;
+    cursor->pile = pile;
+    cursor->pile_no = pile_no;
+    cursor->index = 0;
+    cursor->card_num = pile->card_num;
+    cursor->gap = 0;
+    cursor->removed = 0;
+    cursor->slot = (deck->type == POKER_DECK_ARRAY) ? pile->slot : NULL;
+    cursor->head = pile->head;
+    cursor->mask = deck->mask;
+    cursor->node = pile->top;
+    return POKER_Get_CursorCard(cursor);
+}
+
+/* POKER_Step_Cursor: move a cursor to the next card, POKER_Next_Cursor without its inline steps,
+   * parameter: CURSOR_T *cursor -- the cursor
+   * return value: the next card, POKER_NONE for the end of pile, POKER_ERR for fail */
+int POKER_Step_Cursor(CURSOR_T *cursor)
+{
+    if ((cursor == NULL) || (cursor->deck == NULL)) return POKER_ERR;
+
+    /* the cursor is at the next card already after a removal */
+    if (cursor->removed)
+    {
+        cursor->removed = 0;
+    }
+    else if (cursor->index < cursor->card_num)
+    {
+        if (cursor->slot != NULL)
+        {
+            /* the card kept is moved over the gap */
+            if (cursor->gap > 0)
+                cursor->slot[(cursor->head + cursor->index) & cursor->mask] =
+                    cursor->slot[(cursor->head + cursor->index + cursor->gap) & cursor->mask];
+        }
+        else
+        {
+            cursor->node = cursor->node->next;
+        }
+        cursor->index++;
+    }
+    return POKER_Get_CursorCard(cursor);
+}
+
+/* POKER_Remove_CursorCard: move the current card of a cursor to the bottom of another pile,
+   * parameter: CURSOR_T *cursor -- the cursor
+                int to_pile_no -- the player no, POKER_PILE_LAST or POKER_PILE_TRASH
+   * return value: POKER_OK for success, POKER_ERR for fail
+   * comment: it takes O(1), POKER_Next_Cursor moves to the card after it, the same as
+              POKER_Move_PileRange of the card to the bottom */
+int POKER_Remove_CursorCard(CURSOR_T *cursor, int to_pile_no)
+{
+    DECK_T  *deck = NULL;
+    PILE_T  *from = NULL;
+    PILE_T  *to = NULL;
+    CARD_T  *card = NULL;
+    int     value = 0;
+
+    if ((value = POKER_Get_CursorCard(cursor)) < 0) return POKER_ERR;
+    deck = cursor->deck;
+    from = cursor->pile;
+    if (((to = get_pile(deck, to_pile_no)) == NULL) || (to == from)) return POKER_ERR;
+
+    /* keep the cut card in place as splice_pile */
+    deck->cut_num -= cut_behind(deck, from, cursor->index, 1);
+    if (to == &deck->last_pile) deck->cut_num++;
+
+    if (deck->type == POKER_DECK_ARRAY)
+    {
+        array_insert(deck, to, value, POKER_FROM_BOTTOM);
+        from->card_num--;
+        cursor->gap++;
+    }
+    else
+    {
+        card = cursor->node;
+        cursor->node = card->next;
+        unlink_card(from, card);
+        insert_card(to, card, POKER_FROM_BOTTOM);
+    }
+    cursor->card_num--;
+    if (deck->cardset)
+    {
+        from->set &= ~POKER_Card_Bit(value);
+        to->set |= POKER_Card_Bit(value);
+    }
+    cursor->removed = 1;
+    LOG_OP(deck, LOG_MOVE, 5, cursor->pile_no, cursor->index, 1, to_pile_no, POKER_FROM_BOTTOM);
+    return POKER_OK;
+}
+
+/* POKER_End_Cursor: stop a cursor,
+   * parameter: CURSOR_T *cursor -- the cursor
+   * return value: POKER_OK for success, POKER_ERR for fail
+   * comment: the gap left by cards removed from an array pile is closed and the deck takes other calls again */
+int POKER_End_Cursor(CURSOR_T *cursor)
+{
+    DECK_T *deck = NULL;
+    PILE_T *pile = NULL;
+
+    if ((cursor == NULL) || ((deck = cursor->deck) == NULL)) return POKER_ERR;
+    pile = cursor->pile;
+
+    if ((deck->type == POKER_DECK_ARRAY) && (cursor->gap > 0) && (cursor->index < pile->card_num))
+        ring_copy(deck, pile, cursor->index, pile, cursor->index + cursor->gap, pile->card_num - cursor->index);
+    deck->cursor = 0;
+    cursor->deck = NULL;
+    cursor->card_num = 0;
+    return POKER_OK;
+}
+
+/* POKER_Get_PileCards: copy the cards of a pile from top,
+   * parameter: DECK_TP deck -- the pointer to a deck of poker
+                int pile_no -- the player no, POKER_PILE_LAST or POKER_PILE_TRASH
+                int *cards -- the cards, could be NULL
+                int max -- the most cards to copy
+   * return value: the card number of pile, POKER_ERR for fail */
+int POKER_Get_PileCards(DECK_TP deck, int pile_no, int *cards, int max)
+{
+    PILE_T  *pile = NULL;
+    CARD_T  *card = NULL;
+    int     num = 0;
+    int     chunk = 0;
+    int     idx = 0;
+
+    if ((deck == NULL) || deck->cursor || (max < 0) || ((cards == NULL) && (max > 0))) return POKER_ERR;
+    if ((pile = get_pile(deck, pile_no)) == NULL) return POKER_ERR;
+
+    num = (pile->card_num < max) ? pile->card_num : max;
+    if (deck->type == POKER_DECK_ARRAY)
+    {
+        /* two blocks at most, the ring wraps once */
+        chunk = deck->mask + 1 - pile->head;
+        if (chunk > num) chunk = num;
+        if (chunk > 0) memcpy(cards, &pile->slot[pile->head], chunk * sizeof(int));
+        if (num > chunk) memcpy(cards + chunk, pile->slot, (num - chunk) * sizeof(int));
+        return pile->card_num;
+    }
+    for (card = pile->top; idx < num; card = card->next) cards[idx++] = card->card;
+    return pile->card_num;
+}
+
+/* POKER_Sort_LastPile: sort last pile,
+   * parameter: DECK_TP deck -- the pointer to a deck of poker
+                int (*comp_func)(int card1, int card2) -- the compare rule function
+                    rv definition: = 0 means card1 is equal card2
+                                   > 0 means card1 should be in back of card2
+                                   < 0 means card1 should be in front of card2
+   * return value: POKER_OK for success, POKER_ERR for fail */
+int POKER_Sort_LastPile(DECK_TP deck, int (*comp_func)(int card1, int card2))
+{
+    if ((deck == NULL) || deck->cursor) return POKER_ERR;
+    if (deck->last_pile.card_num == 0) return POKER_OK;
+    
+    STAT_TIME(deck, POKER_STAT_SORT, sort_pile(deck, &deck->last_pile, comp_func));
+    if (deck->log != NULL) log_sort(deck, POKER_PILE_LAST, comp_func);
+    return POKER_OK;
+}
+
+/* POKER_Sort_TrashPile: sort trash pile,
+   * parameter: DECK_TP deck -- the pointer to a deck of poker
+                int (*comp_func)(int card1, int card2) -- the compare rule function
+                    rv definition: = 0 means card1 is equal card2
+                                   > 0 means card1 should be in back of card2
+                                   < 0 means card1 should be in front of card2
+   * return value: POKER_OK for success, POKER_ERR for fail */
+int POKER_Sort_TrashPile(DECK_TP deck, int (*comp_func)(int card1, int card2))
+{
+    if ((deck == NULL) || deck->cursor) return POKER_ERR;
+    if (deck->trash_pile.card_num == 0) return POKER_OK;
+    
+    STAT_TIME(deck, POKER_STAT_SORT, sort_pile(deck, &deck->trash_pile, comp_func));
+    if (deck->log != NULL) log_sort(deck, POKER_PILE_TRASH, comp_func);
+    return POKER_OK;
+}
+
+/* POKER_Sort_PlayerPile: sort a player's pile,
+   * parameter: DECK_TP deck -- the pointer to a deck of poker
+                int player_no -- the player no.
+                int (*comp_func)(int card1, int card2) -- the compare rule function
+                    rv definition: = 0 means card1 is equal card2
+                                   > 0 means card1 should be in back of card2
+                                   < 0 means card1 should be in front of card2
+   * return value: POKER_OK for success, POKER_ERR for fail */
+int POKER_Sort_PlayerPile(DECK_TP deck, int player_no, int (*comp_func)(int card1, int card2))
+{
+    if ((deck == NULL) || deck->cursor) return POKER_ERR;
+    if (deck->player == NULL) return POKER_ERR;
+    if ((player_no < 1) || (deck->player_num < player_no)) return POKER_ERR;
+    if (deck->player[player_no-1].card_num == 0) return POKER_OK;
+    
+    STAT_TIME(deck, POKER_STAT_SORT, sort_pile(deck, &deck->player[player_no-1], comp_func));
+    if (deck->log != NULL) log_sort(deck, player_no, comp_func);
+    return POKER_OK;
+}
+
+/* POKER_Comp_ColorNum: compare rule of spade A ~ K, heart A ~ K, diamond A ~ K, club A ~ K and jokers
+   * comment: sorting with this rule is in linear time, so are the other POKER_Comp_* rules */
+int POKER_Comp_ColorNum(int card1, int card2)
+{
+    return sort_key(POKER_Comp_ColorNum, card1) - sort_key(POKER_Comp_ColorNum, card2);
+}
+
+/* POKER_Comp_ColorNumAceHigh: compare rule of spade 2 ~ A, heart 2 ~ A, diamond 2 ~ A, club 2 ~ A and jokers */
+int POKER_Comp_ColorNumAceHigh(int card1, int card2)
+{
+    return sort_key(POKER_Comp_ColorNumAceHigh, card1) - sort_key(POKER_Comp_ColorNumAceHigh, card2);
+}
+
+/* POKER_Comp_NumColor: compare rule of A ~ K, the same number from spade to club, and jokers */
+int POKER_Comp_NumColor(int card1, int card2)
+{
+    return sort_key(POKER_Comp_NumColor, card1) - sort_key(POKER_Comp_NumColor, card2);
+}
+
+/* POKER_Comp_NumColorAceHigh: compare rule of 2 ~ A, the same number from spade to club, and jokers */
+int POKER_Comp_NumColorAceHigh(int card1, int card2)
+{
+    return sort_key(POKER_Comp_NumColorAceHigh, card1) - sort_key(POKER_Comp_NumColorAceHigh, card2);
+}
+
+/* Fisher-Yates shuffle, every order of cards is equally likely */
+static void shuffle_cards(DECK_T *deck, int *cards, int total)
+{
+    int idx = 0;
+
+    for (idx = total - 1; idx > 0; idx--)
+        swap(&cards[idx], &cards[rand_below(deck, idx + 1)]);
+}
+
+static void shuffle_pile(DECK_T *deck, PILE_T *pile)
+{
+    int     idx = 0;
+    CARD_T  *card = NULL;
+
+    if (deck->type == POKER_DECK_ARRAY)
+    {
+        for (idx = pile->card_num - 1; idx > 0; idx--)
+            swap(&SLOT(deck, pile, idx), &SLOT(deck, pile, rand_below(deck, idx + 1)));
+        return;
+    }
+    /* list has no index access, shuffle the cards in scratch */
+    for (idx = 0, card = pile->top; card != NULL; card = card->next) deck->scratch[idx++] = card->card;
+    shuffle_cards(deck, deck->scratch, pile->card_num);
+    for (idx = 0, card = pile->top; card != NULL; card = card->next) card->card = deck->scratch[idx++];
+}
+
+/* POKER_Shuffle_LastPile: shuffle last pile
+   * parameter: DECK_TP deck -- the pointer to a deck of poker
+   * return value: POKER_OK for success, POKER_ERR for fail */
+int POKER_Shuffle_LastPile(DECK_TP deck)
+{
+    if ((deck == NULL) || deck->cursor) return POKER_ERR;
+    STAT_TIME(deck, POKER_STAT_SHUFFLE, shuffle_pile(deck, &deck->last_pile));
+    LOG_OP(deck, LOG_SHUFFLE, 1, POKER_PILE_LAST);
+    return POKER_OK;    
+}
+
+/* POKER_Shuffle_TrashPile: shuffle trash pile and combine behind last pile
+   * parameter: DECK_TP deck -- the pointer to a deck of poker
    * return value: POKER_OK for success, POKER_ERR for fail */
-int POKER_Throw_LastCard(DECK_TP deck, int type, int index)
+int POKER_Shuffle_TrashPile(DECK_TP deck)
 {
-    if (deck == NULL) return POKER_ERR;
-    if (deck->last_pile.card_num == 0) return POKER_ERR;
-    if (deck->last_pile.card_num <= index) return POKER_ERR;
-    if (deck->trash_pile.card_num == deck->total_num) return POKER_ERR;
-    
-    return insert_card(&deck->trash_pile, remove_card(&deck->last_pile, type, index), POKER_FROM_BOTTOM);
+    if ((deck == NULL) || deck->cursor) return POKER_ERR;
+    STAT_TIME(deck, POKER_STAT_SHUFFLE, shuffle_pile(deck, &deck->trash_pile));
+    append_pile(deck, &deck->trash_pile, &deck->last_pile);
+    LOG_OP(deck, LOG_SHUFFLE, 1, POKER_PILE_TRASH);
+    return POKER_OK;
 }
 
-/* POKER_Throw_PlayerCard: throw a card from player to trash_pile,
+/* POKER_Shuffle_PlayerPile: shuffle a player's pile
    * parameter: DECK_TP deck -- the pointer to a deck of poker
-                int player_no -- the player no
-                int type -- from top, bottom or index of player's pile
-                int index -- the index of player's pile
+                int player_no -- the player no.
    * return value: POKER_OK for success, POKER_ERR for fail */
-int POKER_Throw_PlayerCard(DECK_TP deck, int player_no, int type, int index)
+int POKER_Shuffle_PlayerPile(DECK_TP deck, int player_no)
 {
-    if (deck == NULL) return POKER_ERR;
+    if ((deck == NULL) || deck->cursor) return POKER_ERR;
     if (deck->player == NULL) return POKER_ERR;
-    if (deck->player_num < player_no) return POKER_ERR;
-    if (deck->player[player_no-1].card_num <= index) return POKER_ERR;
-    if (deck->trash_pile.card_num == deck->total_num) return POKER_ERR;
-    
-    return insert_card(&deck->trash_pile, remove_card(&deck->player[player_no-1], type, index), POKER_FROM_BOTTOM);
+    if ((player_no < 1) || (deck->player_num < player_no)) return POKER_ERR;
+    STAT_TIME(deck, POKER_STAT_SHUFFLE, shuffle_pile(deck, &deck->player[player_no-1]));
+    LOG_OP(deck, LOG_SHUFFLE, 1, player_no);
+    return POKER_OK;
 }
 
-static void move_card(PILE_T *pile, CARD_T *move, CARD_T *curr)
+/* POKER_Get_CardSet: get the card set of a pile,
+   * parameter: DECK_TP deck -- the pointer to a deck of poker, created with POKER_DECK_CARDSET
+                int pile_no -- the player no, POKER_PILE_LAST or POKER_PILE_TRASH
+                CARDSET_T *set -- the card set of pile
+   * return value: POKER_OK for success, POKER_ERR for fail */
+int POKER_Get_CardSet(DECK_TP deck, int pile_no, CARDSET_T *set)
 {
-    /* no need to move if neighbor */
-    if (curr->prev == move) return;
+    PILE_T *pile = NULL;
 
-    /* check current is tail */
-    if (pile->bottom == curr)
-    {
-        pile->bottom = curr->prev;
-        pile->bottom->next = NULL;
-    }
-    else
+    if ((deck == NULL) || deck->cursor || (set == NULL)) return POKER_ERR;
+    if (!deck->cardset) return POKER_ERR;
+    if ((pile = get_pile(deck, pile_no)) == NULL) return POKER_ERR;
+    *set = pile->set;
+    return POKER_OK;
+}
+
+/* POKER_Has_Card: check if a pile has a card,
+   * parameter: DECK_TP deck -- the pointer to a deck of poker, created with POKER_DECK_CARDSET
+                int pile_no -- the player no, POKER_PILE_LAST or POKER_PILE_TRASH
+                int card -- the card
+   * return value: POKER_OK for found, POKER_NONE for none, POKER_ERR for failure */
+int POKER_Has_Card(DECK_TP deck, int pile_no, int card)
+{
+    CARDSET_T set = 0;
+
+    if (POKER_Color(card) == POKER_COLOR_JOKER)
     {
-        curr->next->prev = curr->prev;
-        curr->prev->next = curr->next;
+        if ((POKER_Num(card) < 1) || (POKER_Num(card) > POKER_CARDSET_JOKER)) return POKER_ERR;
     }
+    else if ((POKER_Color(card) < POKER_COLOR_CLUB) || (POKER_Color(card) > POKER_COLOR_SPADE) ||
+             (POKER_Num(card) < POKER_NUM_2) || (POKER_Num(card) > POKER_NUM_A)) return POKER_ERR;
+    if (POKER_Get_CardSet(deck, pile_no, &set) != POKER_OK) return POKER_ERR;
+    return (set & POKER_Card_Bit(card)) ? POKER_OK : POKER_NONE;
+}
+
+/* POKER_Count_NumCard: count the cards of a number in a pile,
+   * parameter: DECK_TP deck -- the pointer to a deck of poker, created with POKER_DECK_CARDSET
+                int pile_no -- the player no, POKER_PILE_LAST or POKER_PILE_TRASH
+                int num -- POKER_NUM_2 ~ POKER_NUM_A
+   * return value: the card number, POKER_ERR for failure */
+int POKER_Count_NumCard(DECK_TP deck, int pile_no, int num)
+{
+    CARDSET_T set = 0;
+
+    if ((num < POKER_NUM_2) || (num > POKER_NUM_A)) return POKER_ERR;
+    if (POKER_Get_CardSet(deck, pile_no, &set) != POKER_OK) return POKER_ERR;
+    return __builtin_popcountll(set & (POKER_CARDSET_NUM << (num - POKER_NUM_2)));
+}
+
+/* POKER_Count_ColorCard: count the cards of a color in a pile,
+   * parameter: DECK_TP deck -- the pointer to a deck of poker, created with POKER_DECK_CARDSET
+                int pile_no -- the player no, POKER_PILE_LAST or POKER_PILE_TRASH
+                int color -- POKER_COLOR_SPADE ~ POKER_COLOR_JOKER
+   * return value: the card number, POKER_ERR for failure */
+int POKER_Count_ColorCard(DECK_TP deck, int pile_no, int color)
+{
+    CARDSET_T set = 0;
+
+    if ((color < POKER_COLOR_JOKER) || (color > POKER_COLOR_SPADE) || (POKER_Num(color) != 0)) return POKER_ERR;
+    if (POKER_Get_CardSet(deck, pile_no, &set) != POKER_OK) return POKER_ERR;
+    if (color == POKER_COLOR_JOKER) return __builtin_popcountll(set >> 52);
+    return __builtin_popcountll(set & (POKER_CARDSET_COLOR << (((color >> 4) - 2) * 13)));
+}
+
+/* POKER_And_CardSet: get the cards both in two piles,
+   * parameter: DECK_TP deck -- the pointer to a deck of poker, created with POKER_DECK_CARDSET
+                int pile_no1 -- the player no, POKER_PILE_LAST or POKER_PILE_TRASH
+                int pile_no2 -- the player no, POKER_PILE_LAST or POKER_PILE_TRASH
+                CARDSET_T *set -- the intersection of two card sets
+   * return value: POKER_OK for success, POKER_ERR for fail */
+int POKER_And_CardSet(DECK_TP deck, int pile_no1, int pile_no2, CARDSET_T *set)
+{
+    CARDSET_T set1 = 0;
+    CARDSET_T set2 = 0;
+
+    if (set == NULL) return POKER_ERR;
+    if (POKER_Get_CardSet(deck, pile_no1, &set1) != POKER_OK) return POKER_ERR;
+    if (POKER_Get_CardSet(deck, pile_no2, &set2) != POKER_OK) return POKER_ERR;
+    *set = set1 & set2;
+    return POKER_OK;
+}
+
+/* POKER_Or_CardSet: get the cards in either of two piles,
+   * parameter: DECK_TP deck -- the pointer to a deck of poker, created with POKER_DECK_CARDSET
+                int pile_no1 -- the player no, POKER_PILE_LAST or POKER_PILE_TRASH
+                int pile_no2 -- the player no, POKER_PILE_LAST or POKER_PILE_TRASH
+                CARDSET_T *set -- the union of two card sets
+   * return value: POKER_OK for success, POKER_ERR for fail */
+int POKER_Or_CardSet(DECK_TP deck, int pile_no1, int pile_no2, CARDSET_T *set)
+{
+    CARDSET_T set1 = 0;
+    CARDSET_T set2 = 0;
 
-    /* check target is header */
-    if (move == NULL)
+    if (set == NULL) return POKER_ERR;
+    if (POKER_Get_CardSet(deck, pile_no1, &set1) != POKER_OK) return POKER_ERR;
+    if (POKER_Get_CardSet(deck, pile_no2, &set2) != POKER_OK) return POKER_ERR;
+    *set = set1 | set2;
+    return POKER_OK;
+}
+
+/* pile of snapshot order: last pile, trash pile and players */
+static PILE_T *snap_pile(DECK_T *deck, int idx)
+{
+    if (idx == 0) return &deck->last_pile;
+    if (idx == 1) return &deck->trash_pile;
+    return &deck->player[idx - 2];
+}
+
+/* order of a card in a full deck, POKER_ERR if the deck has no such card */
+static int card_order(DECK_T *deck, int card)
+{
+    int pack = POKER_Pack(card);
+    int color = POKER_Color(card);
+    int num = POKER_Num(card);
+
+    if ((card & ~(POKER_MASK_PACK | POKER_MASK_COLOR | POKER_MASK_NUM)) || (pack >= deck->pack_num)) return POKER_ERR;
+    pack *= POKER_CARD_NUM + deck->joker_num;
+    if (color == POKER_COLOR_JOKER)
     {
-        pile->top->prev = curr;
-        curr->next = pile->top;
-        pile->top = curr;
-        pile->top->prev = NULL;
+        if ((num < 1) || (num > deck->joker_num)) return POKER_ERR;
+        return pack + POKER_CARD_NUM + num - 1;
     }
-    else
+    if ((color < POKER_COLOR_CLUB) || (color > POKER_COLOR_SPADE)) return POKER_ERR;
+    if ((num < POKER_NUM_2) || (num > POKER_NUM_A)) return POKER_ERR;
+    return pack + (color / 0x10 - 2) * 13 + num - POKER_NUM_2;
+}
+
+/* put a card at bottom of a pile being rebuilt, node is the free card node of list type */
+static void load_card(DECK_T *deck, PILE_T *pile, int value, int node)
+{
+    if (deck->cardset) pile->set |= POKER_Card_Bit(value);
+    if (deck->type == POKER_DECK_ARRAY)
     {
-        curr->next = move->next;
-        curr->prev = move;
-        curr->prev->next = curr;
-        curr->next->prev = curr;
+        array_insert(deck, pile, value, POKER_FROM_BOTTOM);
+        return;
     }
+    deck->card[node].card = value;
+    insert_card(pile, &deck->card[node], POKER_FROM_BOTTOM);
+}
+
+static void clear_piles(DECK_T *deck)
+{
+    int idx = 0;
+
+    for (idx = 0; idx < deck->player_num + 2; idx++) clear_pile(snap_pile(deck, idx));
 }
 
+/* POKER_Get_SnapshotSize: get the size of snapshot of a deck,
+   * parameter: DECK_TP deck -- the pointer to a deck of poker
+   * return value: the size in bytes, 0 for failure */
+size_t POKER_Get_SnapshotSize(DECK_TP deck)
+{
+    if ((deck == NULL) || deck->cursor) return 0;
+    return SNAP_HEAD_SIZE + (deck->player_num + 2) * 2 + deck->total_num * ((deck->pack_num > 1) ? 2 : 1);
+}
 
-static void insertion_sort(PILE_T *pile, int (*comp_func)(int card1, int card2))
+/* POKER_Save_Deck: save the cards of every pile, the cut card and random number generator of a deck,
+   * parameter: DECK_TP deck -- the pointer to a deck of poker
+                void *buf -- the snapshot
+                size_t size -- the size of buf, POKER_Get_SnapshotSize at least
+   * return value: the size of snapshot, POKER_ERR for fail
+   * comment: the snapshot has no pointer and is the same on every machine */
+int POKER_Save_Deck(DECK_TP deck, void *buf, size_t size)
 {
-    CARD_T  *curr = NULL;
-    CARD_T  *move = NULL;
-    CARD_T  *tmp = NULL;
-    int     rv = 0;
+    unsigned char   *pos = (unsigned char *)buf;
+    PILE_T          *pile = NULL;
+    CARD_T          *card = NULL;
+    int             wide = 0;
+    int             value = 0;
+    int             pile_idx = 0;
+    int             idx = 0;
+
+    if ((deck == NULL) || deck->cursor || (buf == NULL)) return POKER_ERR;
+    if ((deck->total_num > SNAP_MAX_NUM) || (deck->player_num > SNAP_MAX_NUM)) return POKER_ERR;
+    if (size < POKER_Get_SnapshotSize(deck)) return POKER_ERR;
+
+    wide = (deck->pack_num > 1);
+    memcpy(pos, SNAP_MAGIC, 4);
+    pos[SNAP_WIDTH] = wide ? 2 : 1;
+    pos[SNAP_JOKER] = (unsigned char)deck->joker_num;
+    pos[SNAP_PACK] = (unsigned char)deck->pack_num;
+    pos[SNAP_PACK + 1] = 0;
+    put_16(pos + SNAP_PLAYER, deck->player_num);
+    put_16(pos + SNAP_TOTAL, deck->total_num);
+    put_16(pos + SNAP_CUT, deck->cut_num);
+    put_16(pos + SNAP_CUT + 2, 0);
+    for (idx = 0; idx < 4; idx++) put_64(pos + SNAP_RAND + idx * 8, deck->rand_state[idx]);
+    pos += SNAP_HEAD_SIZE;
+    for (pile_idx = 0; pile_idx < deck->player_num + 2; pile_idx++, pos += 2)
+        put_16(pos, snap_pile(deck, pile_idx)->card_num);
 
-    curr = pile->top->next;
-    while (curr != NULL)
+    for (pile_idx = 0; pile_idx < deck->player_num + 2; pile_idx++)
     {
-        tmp = curr->next;
-        move = curr->prev;
-        while (move != NULL)
+        pile = snap_pile(deck, pile_idx);
+        card = pile->top;
+        for (idx = 0; idx < pile->card_num; idx++)
         {
-            rv = comp_func(move->card, curr->card);
-            if (rv == 0) break;
-            else if (rv < 0)
+            if (deck->type == POKER_DECK_ARRAY) value = SLOT(deck, pile, idx);
+            else
+            {
+                value = card->card;
+                card = card->next;
+            }
+            if (wide)
             {
-                move_card(pile, move, curr);
-                break;
+                put_16(pos, value);
+                pos += 2;
             }
-            if ((move = move->prev) == NULL) move_card(pile, move, curr);
+            else *pos++ = (unsigned char)value;
         }
-        curr = tmp;
     }
+    return (int)(pos - (unsigned char *)buf);
 }
 
-/* POKER_Dump_PlayerPile: dump a player's pile, the way appointed in dump_func
-   * parameter: DECK_TP deck -- the pointer to a deck of poker
-                int player_no -- the player no.
-                void (*dump_func)(int index, int card, void *para) -- the dump rule function,
-                void *para -- user parameter */
-void POKER_Dump_PlayerPile(DECK_TP deck, int player_no, void (*dump_func)(int index, int card, void *para), void *para)
+/* POKER_Load_Deck: restore a deck from a snapshot of POKER_Save_Deck, no memory is allocated
+   * parameter: DECK_TP deck -- the pointer to a deck of poker, with the same players, jokers and packs
+                               as the saved deck, of any pile storage type
+                const void *buf -- the snapshot
+                size_t size -- the size of buf
+   * return value: POKER_OK for success, POKER_ERR for fail, the deck is not changed if fail */
+int POKER_Load_Deck(DECK_TP deck, const void *buf, size_t size)
 {
-    int     idx = 0;
-    CARD_T  *tmp = NULL;
+    const unsigned char *head = (const unsigned char *)buf;
+    const unsigned char *pos = NULL;
+    PILE_T              *pile = NULL;
+    int                 wide = 0;
+    int                 value = 0;
+    int                 order = 0;
+    int                 pile_idx = 0;
+    int                 num = 0;
+    int                 idx = 0;
+    int                 node = 0;
 
-    if (deck == NULL) return;
-    if (deck->player == NULL) return;
-    if (deck->player_num < player_no) return;
-    for (tmp = deck->player[player_no-1].top; tmp != NULL; tmp = tmp->next)
+    if ((deck == NULL) || deck->cursor || (buf == NULL)) return POKER_ERR;
+    if (size < POKER_Get_SnapshotSize(deck)) return POKER_ERR;
+    wide = (deck->pack_num > 1);
+    if ((memcmp(head, SNAP_MAGIC, 4) != 0) || (head[SNAP_WIDTH] != (wide ? 2 : 1))) return POKER_ERR;
+    if ((head[SNAP_JOKER] != deck->joker_num) || (head[SNAP_PACK] != deck->pack_num)) return POKER_ERR;
+    if ((get_16(head + SNAP_PLAYER) != deck->player_num) || (get_16(head + SNAP_TOTAL) != deck->total_num)) return POKER_ERR;
+
+    /* every card of deck is in one pile once, scratch marks the cards seen */
+    pos = head + SNAP_HEAD_SIZE;
+    for (pile_idx = 0; pile_idx < deck->player_num + 2; pile_idx++, pos += 2) num += get_16(pos);
+    if (num != deck->total_num) return POKER_ERR;
+    if (get_16(head + SNAP_CUT) > get_16(head + SNAP_HEAD_SIZE)) return POKER_ERR;
+    memset(deck->scratch, 0, deck->total_num * sizeof(int));
+    for (idx = 0; idx < num; idx++)
     {
-        dump_func(idx++, tmp->card, para);
+        value = wide ? get_16(pos + idx * 2) : pos[idx];
+        if ((order = card_order(deck, value)) == POKER_ERR) return POKER_ERR;
+        if (deck->scratch[order]) return POKER_ERR;
+        deck->scratch[order] = 1;
+    }
+
+    clear_piles(deck);
+    deck->cut_num = get_16(head + SNAP_CUT);
+    for (idx = 0; idx < 4; idx++) deck->rand_state[idx] = get_64(head + SNAP_RAND + idx * 8);
+    for (pile_idx = 0; pile_idx < deck->player_num + 2; pile_idx++)
+    {
+        pile = snap_pile(deck, pile_idx);
+        num = get_16(head + SNAP_HEAD_SIZE + pile_idx * 2);
+        for (idx = 0; idx < num; idx++, node++)
+        {
+            value = wide ? get_16(pos) : *pos;
+            pos += wide ? 2 : 1;
+            load_card(deck, pile, value, node);
+        }
     }
+    if (deck->log != NULL) log_snapshot(deck);
+    return POKER_OK;
 }
 
-/* POKER_Dump_LastPile: dump last pile, the way appointed in dump_func
-   * parameter: DECK_TP deck -- the pointer to a deck of poker
-                void (*dump_func)(int index, int card, void *para) -- the dump rule function,
-                void *para -- user parameter */
-void POKER_Dump_LastPile(DECK_TP deck, void (*dump_func)(int index, int card, void *para), void *para)
+/* copy the piles of a deck to another deck of the same players, jokers and packs */
+static void copy_deck(DECK_T *to, DECK_T *from)
 {
+    PILE_T  *to_pile = NULL;
+    PILE_T  *from_pile = NULL;
+    CARD_T  *card = NULL;
+    int     *slot = NULL;
+    int     pile_idx = 0;
     int     idx = 0;
-    CARD_T  *tmp = NULL;
+    int     node = 0;
 
-    if (deck == NULL) return;
-    for (tmp = deck->last_pile.top; tmp != NULL; tmp = tmp->next)
+    to->cut_num = from->cut_num;
+    memcpy(to->rand_state, from->rand_state, sizeof(to->rand_state));
+    if ((to->type == from->type) && (to->cardset == from->cardset))
     {
-        dump_func(idx++, tmp->card, para);
+        if (to->type == POKER_DECK_ARRAY)
+        {
+            /* slots of all piles are one block after last pile */
+            memcpy(to->last_pile.slot, from->last_pile.slot, (size_t)(to->mask + 1) * (to->player_num + 2) * sizeof(int));
+            for (pile_idx = 0; pile_idx < to->player_num + 2; pile_idx++)
+            {
+                to_pile = snap_pile(to, pile_idx);
+                slot = to_pile->slot;
+                *to_pile = *snap_pile(from, pile_idx);
+                to_pile->slot = slot;
+            }
+            return;
+        }
+
+        /* card nodes are at the same places of both blocks */
+        for (idx = 0; idx < to->total_num; idx++)
+        {
+            card = &from->card[idx];
+            to->card[idx].card = card->card;
+            to->card[idx].next = (card->next == NULL) ? NULL : to->card + (card->next - from->card);
+            to->card[idx].prev = (card->prev == NULL) ? NULL : to->card + (card->prev - from->card);
+        }
+        for (pile_idx = 0; pile_idx < to->player_num + 2; pile_idx++)
+        {
+            to_pile = snap_pile(to, pile_idx);
+            from_pile = snap_pile(from, pile_idx);
+            *to_pile = *from_pile;
+            to_pile->top = (from_pile->top == NULL) ? NULL : to->card + (from_pile->top - from->card);
+            to_pile->bottom = (from_pile->bottom == NULL) ? NULL : to->card + (from_pile->bottom - from->card);
+        }
+        return;
+    }
+
+    clear_piles(to);
+    for (pile_idx = 0; pile_idx < to->player_num + 2; pile_idx++)
+    {
+        to_pile = snap_pile(to, pile_idx);
+        from_pile = snap_pile(from, pile_idx);
+        card = from_pile->top;
+        for (idx = 0; idx < from_pile->card_num; idx++, node++)
+        {
+            if (from->type == POKER_DECK_ARRAY) load_card(to, to_pile, SLOT(from, from_pile, idx), node);
+            else
+            {
+                load_card(to, to_pile, card->card, node);
+                card = card->next;
+            }
+        }
     }
 }
 
-/* POKER_Dump_TrashPile: dump trash pile, the way appointed in dump_func
-   * parameter: DECK_TP deck -- the pointer to a deck of poker
-                void (*dump_func)(int index, int card, void *para) -- the dump rule function,
-                void *para -- user parameter */
-void POKER_Dump_TrashPile(DECK_TP deck, void (*dump_func)(int index, int card, void *para), void *para)
+/* POKER_Copy_Deck: copy the cards of every pile, the cut card and random number generator of a deck
+                    to another deck, no memory is allocated
+   * parameter: DECK_TP to -- the pointer to a deck of poker, with the same players, jokers and packs
+                DECK_TP from -- the pointer to a deck of poker
+   * return value: POKER_OK for success, POKER_ERR for fail
+   * comment: decks of the same storage type are copied in memory blocks */
+int POKER_Copy_Deck(DECK_TP to, DECK_TP from)
 {
-    int     idx = 0;
-    CARD_T  *tmp = NULL;
+    if ((to == NULL) || (from == NULL) || to->cursor || from->cursor) return POKER_ERR;
+    if (to == from) return POKER_OK;
+    if ((to->player_num != from->player_num) || (to->joker_num != from->joker_num) ||
+        (to->pack_num != from->pack_num)) return POKER_ERR;
 
-    if (deck == NULL) return;
-    for (tmp = deck->trash_pile.top; tmp != NULL; tmp = tmp->next)
-    {
-        dump_func(idx++, tmp->card, para);
-    }
+    copy_deck(to, from);
+    if (to->log != NULL) log_snapshot(to);
+    return POKER_OK;
 }
 
-/* POKER_Search_PlayerPile: search from player's pile, the way appointed in search_func
+/* POKER_Clone_Deck: create a deck of poker the same as another,
    * parameter: DECK_TP deck -- the pointer to a deck of poker
-                int player_no -- the player no.
-                int (*search_func)(int index, int card, void *para) -- the search rule function,
-                void *para -- user parameter
-   * return value: POKER_OK for found, POKER_NONE for none, POKER_ERR for failure
-   * comment: if the search func return POKER_OK, means found and function will return, else keep loop searching    */
-int POKER_Search_PlayerPile(DECK_TP deck, int player_no, 
-                            int (*search_func)(int index, int card, void *para), void *para)
+   * return value: the pointer to a new deck of poker, NULL for failure
+   * comment: the clone has the random number generator state of deck, OS entropy is not read */
+DECK_TP POKER_Clone_Deck(DECK_TP deck)
 {
-    int     idx = 0;
-    CARD_T  *tmp = NULL;
+    DECK_TP clone = NULL;
+    int     flag = 0;
 
-    if (deck == NULL) return POKER_ERR;
-    if (deck->player == NULL) return POKER_ERR;
-    if (deck->player_num < player_no) return POKER_ERR;
-    for (tmp = deck->player[player_no-1].top; tmp != NULL; tmp = tmp->next)
-    {
-        if (search_func(idx++, tmp->card, para) == POKER_OK) return POKER_OK;
-    }
-    return POKER_NONE;
+    if ((deck == NULL) || deck->cursor) return NULL;
+    flag = deck->type | POKER_DECK_PACK(deck->pack_num);
+    if (deck->cardset) flag |= POKER_DECK_CARDSET;
+    if ((clone = create_deck(deck->player_num, deck->joker_num, flag)) == NULL) return NULL;
+    POKER_Copy_Deck(clone, deck);
+    return clone;
 }
 
-/* POKER_Search_LastPile: search from last pile, the way appointed in search_func
-   * parameter: DECK_TP deck -- the pointer to a deck of poker
-                int (*search_func)(int index, int card, void *para) -- the dump rule function,
-                void *para -- user parameter
-   * return value: POKER_OK for found, POKER_NONE for none, POKER_ERR for failure
-   * comment: if the search func return POKER_OK, means found and function will return, else keep loop searching    */
-int POKER_Search_LastPile(DECK_TP deck, int (*search_func)(int index, int card, void *para), void *para)
+const int poker_log_args[LOG_OP_NUM] = { 0, 0, 1, 4, 2, 1, 3, 2, 2, 1, 4, 2, 3, 1, 5, 2, 1, 10 };
+
+/* compare rules logged by number, sorts of other rules are logged as a snapshot */
+static int (* const sort_rules[])(int card1, int card2) =
 {
-    int     idx = 0;
-    CARD_T  *tmp = NULL;
+    POKER_Comp_ColorNum, POKER_Comp_ColorNumAceHigh, POKER_Comp_NumColor, POKER_Comp_NumColorAceHigh
+};
+
+struct log_s
+{
+    int             fd;
+    int             err;        /* a write failed */
+    size_t          size;       /* size of buf */
+    size_t          len;        /* bytes in buf */
+    unsigned char   *buf;
+};
+
+/* write the buffered records to fd */
+static int log_write(LOG_T *log)
+{
+    size_t  done = 0;
+    ssize_t num = 0;
 
-    if (deck == NULL) return POKER_ERR;
-    for (tmp = deck->last_pile.top; tmp != NULL; tmp = tmp->next)
+    while ((done < log->len) && !log->err)
     {
-        if (search_func(idx++, tmp->card, para) == POKER_OK) return POKER_OK;
+        num = write(log->fd, log->buf + done, log->len - done);
+        if ((num < 0) && (errno == EINTR)) continue;
+        if (num <= 0) log->err = 1;
+        else done += num;
     }
-    return POKER_NONE;
+    log->len = 0;
+    return log->err ? POKER_ERR : POKER_OK;
 }
 
-/* POKER_Search_TrashPile: search trash pile, the way appointed in search_func
-   * parameter: DECK_TP deck -- the pointer to a deck of poker
-                int (*search_func)(int index, int card, void *para) -- the dump rule function,
-                void *para -- user parameter
-   * return value: POKER_OK for found, POKER_NONE for none, POKER_ERR for failure
-   * comment: if the search func return POKER_OK, means found and function will return, else keep loop searching    */
-int POKER_Search_TrashPile(DECK_TP deck, int (*search_func)(int index, int card, void *para), void *para)
+/* room of need bytes in the buffer, need is not more than its size */
+static unsigned char *log_reserve(LOG_T *log, size_t need)
 {
-    int     idx = 0;
-    CARD_T  *tmp = NULL;
+    unsigned char *pos = NULL;
+
+    if (log->len + need > log->size) log_write(log);
+    pos = log->buf + log->len;
+    log->len += need;
+    return pos;
+}
+
+static void log_op(DECK_T *deck, int op, int num, ...)
+{
+    unsigned char   *pos = log_reserve(deck->log, 1 + num * 2);
+    va_list         args;
+    int             idx = 0;
+
+    *pos++ = (unsigned char)op;
+    va_start(args, num);
+    for (idx = 0; idx < num; idx++, pos += 2) put_16(pos, va_arg(args, int) & 0xFFFF);
+    va_end(args);
+}
 
-    if (deck == NULL) return POKER_ERR;
-    for (tmp = deck->trash_pile.top; tmp != NULL; tmp = tmp->next)
+static void log_snapshot(DECK_T *deck)
+{
+    int             size = (int)POKER_Get_SnapshotSize(deck);
+    unsigned char   *pos = log_reserve(deck->log, LOG_SNAP_HEAD + size);
+
+    pos[0] = LOG_SNAPSHOT;
+    put_32(pos + 1, size);
+    POKER_Save_Deck(deck, pos + LOG_SNAP_HEAD, size);
+}
+
+static void log_sort(DECK_T *deck, int pile_no, int (*comp_func)(int card1, int card2))
+{
+    int rule = 0;
+
+    for (rule = 0; rule < (int)(sizeof(sort_rules) / sizeof(sort_rules[0])); rule++)
     {
-        if (search_func(idx++, tmp->card, para) == POKER_OK) return POKER_OK;
+        if (comp_func != sort_rules[rule]) continue;
+        log_op(deck, LOG_SORT, 2, pile_no, rule);
+        return;
     }
-    return POKER_NONE;
+    log_snapshot(deck);
 }
 
-/* POKER_Sort_LastPile: sort last pile,
+/* POKER_Open_Log: log every change of a deck to a file descriptor, for POKER_Replay_Log
    * parameter: DECK_TP deck -- the pointer to a deck of poker
-                int (*comp_func)(int card1, int card2) -- the compare rule function
-                    rv definition: = 0 means card1 is equal card2
-                                   > 0 means card1 should be in back of card2
-                                   < 0 means card1 should be in front of card2
-   * return value: POKER_OK for success, POKER_ERR for fail */
-int POKER_Sort_LastPile(DECK_TP deck, int (*comp_func)(int card1, int card2))
+                int fd -- the file descriptor opened for writing by caller
+                size_t size -- the bytes buffered between writes, 0 for POKER_LOG_SIZE
+   * return value: POKER_OK for success, POKER_ERR for fail
+   * comment: the log starts with a snapshot of deck, records are written when the buffer is full
+              and by POKER_Flush_Log, POKER_Close_Log or POKER_Delete_Deck */
+int POKER_Open_Log(DECK_TP deck, int fd, size_t size)
 {
-    if (deck == NULL) return POKER_ERR;
-    if (deck->last_pile.card_num == 0) return POKER_OK;
-    
-    insertion_sort(&deck->last_pile, comp_func);
+    LOG_T   *log = NULL;
+    size_t  least = 0;
+
+    if ((deck == NULL) || deck->cursor || (fd < 0)) return POKER_ERR;
+    if (deck->log != NULL) return POKER_ERR;
+    if ((deck->total_num > LOG_MAX_NUM) || (deck->player_num > LOG_MAX_NUM)) return POKER_ERR;
+
+    /* a snapshot record fits in the buffer */
+    if (size == 0) size = POKER_LOG_SIZE;
+    least = LOG_SNAP_HEAD + POKER_Get_SnapshotSize(deck);
+    if (size < least) size = least;
+    if ((log = malloc(sizeof(LOG_T) + size)) == NULL) return POKER_ERR;
+    STAT_ADD(deck, allocs, 1);
+
+    memset(log, 0, sizeof(LOG_T));
+    log->fd = fd;
+    log->size = size;
+    log->buf = (unsigned char *)(log + 1);
+    deck->log = log;
+    log_snapshot(deck);
     return POKER_OK;
 }
 
-/* POKER_Sort_TrashPile: sort trash pile,
+/* POKER_Flush_Log: write the buffered records of log,
    * parameter: DECK_TP deck -- the pointer to a deck of poker
-                int (*comp_func)(int card1, int card2) -- the compare rule function
-                    rv definition: = 0 means card1 is equal card2
-                                   > 0 means card1 should be in back of card2
-                                   < 0 means card1 should be in front of card2
-   * return value: POKER_OK for success, POKER_ERR for fail */
-int POKER_Sort_TrashPile(DECK_TP deck, int (*comp_func)(int card1, int card2))
+   * return value: POKER_OK for success, POKER_ERR for fail or a write failed since the log is opened */
+int POKER_Flush_Log(DECK_TP deck)
 {
-    if (deck == NULL) return POKER_ERR;
-    if (deck->trash_pile.card_num == 0) return POKER_OK;
-    
-    insertion_sort(&deck->trash_pile, comp_func);
-    return POKER_OK;
+    if ((deck == NULL) || deck->cursor || (deck->log == NULL)) return POKER_ERR;
+    return log_write(deck->log);
 }
 
-/* POKER_Sort_PlayerPile: sort a player's pile,
+/* POKER_Close_Log: write the buffered records and stop logging, the file descriptor is not closed
    * parameter: DECK_TP deck -- the pointer to a deck of poker
-                int player_no -- the player no.
-                int (*comp_func)(int card1, int card2) -- the compare rule function
-                    rv definition: = 0 means card1 is equal card2
-                                   > 0 means card1 should be in back of card2
-                                   < 0 means card1 should be in front of card2
-   * return value: POKER_OK for success, POKER_ERR for fail */
-int POKER_Sort_PlayerPile(DECK_TP deck, int player_no, int (*comp_func)(int card1, int card2))
+   * return value: POKER_OK for success, POKER_ERR for fail or a write failed since the log is opened */
+int POKER_Close_Log(DECK_TP deck)
 {
-    if (deck == NULL) return POKER_ERR;
-    if (deck->player == NULL) return POKER_ERR;
-    if (deck->player_num < player_no) return POKER_ERR;
-    if (deck->player[player_no-1].card_num == 0) return POKER_OK;
-    
-    insertion_sort(&deck->player[player_no-1], comp_func);
+    int rv = POKER_ERR;
+
+    if ((deck == NULL) || deck->cursor || (deck->log == NULL)) return POKER_ERR;
+    rv = log_write(deck->log);
+    free(deck->log);
+    deck->log = NULL;
+    return rv;
+}
+
+/* POKER_Mark_Hand: mark the start of a hand in the log of deck, for POKER_Write_Archive
+   * parameter: DECK_TP deck -- the pointer to a deck of poker with a log
+                unsigned long long hand_id -- the id of hand
+                unsigned long long time -- the time of hand, in any unit of caller
+                int table -- the table of hand, >= 0
+   * return value: POKER_OK for success, POKER_ERR for fail
+   * comment: a snapshot of deck follows the mark, so a hand is replayed without the records before it */
+int POKER_Mark_Hand(DECK_TP deck, unsigned long long hand_id, unsigned long long time, int table)
+{
+    unsigned char *pos = NULL;
+
+    if ((deck == NULL) || deck->cursor || (deck->log == NULL) || (table < 0)) return POKER_ERR;
+    pos = log_reserve(deck->log, LOG_HAND_SIZE);
+    pos[0] = LOG_HAND;
+    put_64(pos + 1, hand_id);
+    put_64(pos + 9, time);
+    put_32(pos + 17, (unsigned int)table);
+    log_snapshot(deck);
     return POKER_OK;
 }
 
-static void shuffle_pile(PILE_T *pile, int total)
+/* apply an operation of log with its arguments */
+static int replay_op(DECK_T *deck, int op, const int *arg)
 {
-    int     rand_num = 0;
-    CARD_T  *card = NULL;
-    CARD_T  *card_swap = NULL;
-    
-    for (card = pile->top; card != NULL; card = card->next)
+    unsigned long long seed = 0;
+
+    switch (op)
     {
-        rand_num = rand() % total;
-        card_swap = pile->top;
-        while (rand_num-- > 0) card_swap = card_swap->next;
-        swap(&card->card, &card_swap->card);
+        case LOG_RESET:
+            return POKER_Reset_Deck(deck, arg[0]);
+        case LOG_SEED:
+            seed = (unsigned long long)(arg[0] & 0xFFFF) | ((unsigned long long)(arg[1] & 0xFFFF) << 16) |
+                   ((unsigned long long)(arg[2] & 0xFFFF) << 32) | ((unsigned long long)(arg[3] & 0xFFFF) << 48);
+            return POKER_Seed_Deck(deck, seed);
+        case LOG_RAND:
+            return (POKER_Rand_Deck(deck, (arg[0] & 0xFFFF) | ((arg[1] & 0xFFFF) << 16)) < 0) ? POKER_ERR : POKER_OK;
+        case LOG_CUT:
+            return POKER_Set_CutCard(deck, arg[0]);
+        case LOG_DEAL_CARD:
+            return POKER_Deal_Card(deck, arg[0], arg[1], arg[2]);
+        case LOG_DEAL_CARDS:
+            return POKER_Deal_Cards(deck, arg[0], arg[1]);
+        case LOG_DEAL_ROUND:
+            return POKER_Deal_Round(deck, arg[0], arg[1]);
+        case LOG_DEAL_ALL:
+            return POKER_Deal_All(deck, arg[0]);
+        case LOG_TRANSFER:
+            return POKER_Transfer_PlayerCard(deck, arg[0], arg[1], arg[2], arg[3]);
+        case LOG_THROW_LAST:
+            return POKER_Throw_LastCard(deck, arg[0], arg[1]);
+        case LOG_THROW_PLAYER:
+            return POKER_Throw_PlayerCard(deck, arg[0], arg[1], arg[2]);
+        case LOG_THROW_PAIR:
+            return (POKER_Throw_PlayerPair(deck, arg[0], NULL, 0) < 0) ? POKER_ERR : POKER_OK;
+        case LOG_MOVE:
+            return POKER_Move_PileRange(deck, arg[0], arg[1], arg[2], arg[3], arg[4]);
+        case LOG_SORT:
+            if ((arg[1] < 0) || (arg[1] >= (int)(sizeof(sort_rules) / sizeof(sort_rules[0])))) return POKER_ERR;
+            if (arg[0] == POKER_PILE_LAST) return POKER_Sort_LastPile(deck, sort_rules[arg[1]]);
+            if (arg[0] == POKER_PILE_TRASH) return POKER_Sort_TrashPile(deck, sort_rules[arg[1]]);
+            return POKER_Sort_PlayerPile(deck, arg[0], sort_rules[arg[1]]);
+        case LOG_SHUFFLE:
+            if (arg[0] == POKER_PILE_LAST) return POKER_Shuffle_LastPile(deck);
+            if (arg[0] == POKER_PILE_TRASH) return POKER_Shuffle_TrashPile(deck);
+            return POKER_Shuffle_PlayerPile(deck, arg[0]);
+        default:
+            return POKER_ERR;
     }
 }
 
-/* POKER_Shuffle_LastPile: shuffle last pile
-   * parameter: DECK_TP deck -- the pointer to a deck of poker
-   * return value: POKER_OK for success, POKER_ERR for fail */
-int POKER_Shuffle_LastPile(DECK_TP deck)
+/* POKER_Replay_Log: apply the records of a log to a deck,
+   * parameter: DECK_TP deck -- the pointer to a deck of poker, with the same players, jokers and packs
+                               as the logged deck
+                const void *buf -- the records of POKER_Open_Log
+                size_t size -- the size of buf
+                int max -- the most records to apply, < 0 for all
+                size_t *used -- the bytes of records applied, could be NULL
+   * return value: the number of records applied, POKER_ERR for a bad record or a failed operation
+   * comment: a record cut at the end of buf is left, a log starts with a snapshot of the whole deck */
+int POKER_Replay_Log(DECK_TP deck, const void *buf, size_t size, int max, size_t *used)
 {
-    if (deck == NULL) return POKER_ERR;
-    shuffle_pile(&deck->last_pile, deck->last_pile.card_num);
-    return POKER_OK;    
+    const unsigned char *data = (const unsigned char *)buf;
+    size_t              pos = 0;
+    long                len = 0;
+    int                 arg[LOG_MAX_ARG];
+    int                 count = 0;
+    int                 op = 0;
+    int                 rv = POKER_OK;
+    int                 idx = 0;
+
+    if ((deck == NULL) || deck->cursor || ((buf == NULL) && (size > 0))) return POKER_ERR;
+
+    for (count = 0; ((max < 0) || (count < max)) && (pos < size) && (rv == POKER_OK); count++)
+    {
+        if ((len = log_record_size(data + pos, size - pos)) <= 0)
+        {
+            if (len < 0) rv = POKER_ERR;
+            break;
+        }
+        op = data[pos];
+        if (op == LOG_SNAPSHOT)
+        {
+            rv = POKER_Load_Deck(deck, data + pos + LOG_SNAP_HEAD, len - LOG_SNAP_HEAD);
+        }
+        else if (op != LOG_HAND)
+        {
+            /* arguments are signed 16 bits */
+            for (idx = 0; idx < poker_log_args[op]; idx++) arg[idx] = (short)get_16(data + pos + 1 + idx * 2);
+            rv = replay_op(deck, op, arg);
+        }
+        if (rv == POKER_OK) pos += len;
+    }
+    if (used != NULL) *used = pos;
+    return (rv == POKER_OK) ? count : POKER_ERR;
 }
 
-/* POKER_Shuffle_TrashPile: shuffle trash pile and combine behind last pile
+/* POKER_Get_DeckStat: get the counters of a deck since it is created or reset,
    * parameter: DECK_TP deck -- the pointer to a deck of poker
-   * return value: POKER_OK for success, POKER_ERR for fail */
-int POKER_Shuffle_TrashPile(DECK_TP deck)
+                STAT_T *stat -- the counters
+   * return value: POKER_OK for success, POKER_NONE if the library is built without POKER_STAT,
+                   POKER_ERR for fail
+   * comment: counters cost nothing if POKER_STAT is not defined */
+int POKER_Get_DeckStat(DECK_TP deck, STAT_T *stat)
 {
-    if (deck == NULL) return POKER_ERR;
-    shuffle_pile(&deck->trash_pile, deck->trash_pile.card_num);
-    while (deck->trash_pile.card_num != 0)
-    {
-        insert_card(&deck->last_pile, remove_card(&deck->trash_pile, POKER_FROM_TOP, 0), POKER_FROM_BOTTOM);
-    }
+    if ((deck == NULL) || deck->cursor || (stat == NULL)) return POKER_ERR;
+#ifdef POKER_STAT
+    *stat = deck->stat;
     return POKER_OK;
+#else
+    memset(stat, 0, sizeof(STAT_T));
+    return POKER_NONE;
+#endif
 }
 
-/* POKER_Shuffle_PlayerPile: shuffle a player's pile
+/* POKER_Reset_DeckStat: clear the counters of a deck,
    * parameter: DECK_TP deck -- the pointer to a deck of poker
-                int player_no -- the player no.
-   * return value: POKER_OK for success, POKER_ERR for fail */
-int POKER_Shuffle_PlayerPile(DECK_TP deck, int player_no)
+   * return value: POKER_OK for success, POKER_NONE if the library is built without POKER_STAT,
+                   POKER_ERR for fail */
+int POKER_Reset_DeckStat(DECK_TP deck)
 {
-    if (deck == NULL) return POKER_ERR;
-    if (deck->player == NULL) return POKER_ERR;
-    if (deck->player_num < player_no) return POKER_ERR;
-    shuffle_pile(&deck->player[player_no-1], deck->player[player_no-1].card_num);
+    if ((deck == NULL) || deck->cursor) return POKER_ERR;
+#ifdef POKER_STAT
+    memset(&deck->stat, 0, sizeof(STAT_T));
     return POKER_OK;
+#else
+    return POKER_NONE;
+#endif
 }
-
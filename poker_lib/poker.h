@@ -1,4 +1,7 @@
-/* poker library header file */
+/* poker library header file
+   * thread safety: the library has no global state but read only tables of hand evaluator, every
+                    deck owns its cards and random number generator, so different decks can be created,
+                    used and deleted in different threads at the same time. A deck used by more than one thread needs a lock of caller. */
 #ifndef _POKER_H_
 #define _POKER_H_
 
@@ -14,6 +17,7 @@
 
 #define POKER_MASK_COLOR  0xF0
 #define POKER_MASK_NUM    0x0F
+#define POKER_MASK_PACK   0xFF00
 
 #define POKER_COLOR_SPADE    0x50
 #define POKER_COLOR_HEART    0x40
@@ -41,10 +45,121 @@
 #define POKER_FROM_TOP    1
 #define POKER_FROM_BOTTOM 2
 
+#define POKER_DECK_LIST   0x00  /* piles are linked lists of cards */
+#define POKER_DECK_ARRAY  0x01  /* piles are arrays of cards, index access in O(1) */
+#define POKER_DECK_CARDSET 0x02 /* keep a card set of every pile, at most 12 jokers, one pack */
+#define POKER_DECK_PACK(n) ((n) << 8)  /* a shoe of n packs (1 ~ 255), joker_num is for every pack */
+#define POKER_DECK_PACK_MASK 0xFF00
+
+#define POKER_PILE_LAST   0     /* pile_no of last pile, players are 1 ~ players */
+#define POKER_PILE_TRASH  -1    /* pile_no of trash pile */
+
+#define POKER_LOG_SIZE    65536 /* default bytes buffered by the log of a deck */
+#define POKER_ARCHIVE_STEP 64   /* default hands of an index entry of archive */
+
+/* card set: one bit a card, bit 0 ~ 51 are club 2 ~ A, diamond 2 ~ A, heart 2 ~ A and spade 2 ~ A,
+   bit 52 ~ 63 are joker 1 ~ 12 */
+typedef unsigned long long CARDSET_T;
+
+#define POKER_CARDSET_NUM    0x0008004002001ULL  /* the 2 of every color */
+#define POKER_CARDSET_COLOR  0x1FFFULL           /* all numbers of club */
+#define POKER_CARDSET_JOKER  12
+
+#define POKER_HAND_HIGH_CARD        1   /* hand types of POKER_Hand_Type */
+#define POKER_HAND_ONE_PAIR         2
+#define POKER_HAND_TWO_PAIR         3
+#define POKER_HAND_THREE_OF_A_KIND  4
+#define POKER_HAND_STRAIGHT         5
+#define POKER_HAND_FLUSH            6
+#define POKER_HAND_FULL_HOUSE       7
+#define POKER_HAND_FOUR_OF_A_KIND   8
+#define POKER_HAND_STRAIGHT_FLUSH   9
+
+#define POKER_EQUITY_PLAYER  10     /* most players of POKER_Calc_Equity */
+
+/* equity of players, from POKER_Calc_Equity */
+typedef struct equity_s
+{
+    int                 player_num;
+    unsigned long long  total;                          /* boards dealt */
+    unsigned long long  win[POKER_EQUITY_PLAYER];       /* boards won alone */
+    unsigned long long  tie[POKER_EQUITY_PLAYER];       /* boards won with other players */
+    double              equity[POKER_EQUITY_PLAYER];    /* share of pot, 0 ~ 1 */
+} EQUITY_T;
+
+#define POKER_RANGE_COMBO    1326   /* combinations of 2 cards of a pack */
+#define POKER_RANGE_MATCHUP  (1 << 22)  /* most product of combinations of ranges of POKER_Calc_RangeEquity */
+
+/* hand range of Texas Hold'em, from POKER_Parse_Range */
+typedef struct range_s
+{
+    int                 combo_num;
+    int                 card[POKER_RANGE_COMBO][2];     /* 2 hole cards of every combination */
+    double              weight[POKER_RANGE_COMBO];      /* weight of every combination, 0 ~ 1 */
+} RANGE_T;
+
+#define POKER_STAT_SHOW     0   /* operations of STAT_T: POKER_Show_*Card */
+#define POKER_STAT_DEAL     1   /* POKER_Deal_* */
+#define POKER_STAT_THROW    2   /* POKER_Throw_* */
+#define POKER_STAT_MOVE     3   /* POKER_Move_Pile, POKER_Move_PileRange */
+#define POKER_STAT_SORT     4   /* POKER_Sort_*Pile */
+#define POKER_STAT_SEARCH   5   /* POKER_Search_*Pile */
+#define POKER_STAT_SHUFFLE  6   /* POKER_Shuffle_*Pile */
+#define POKER_STAT_TRANSFER 7   /* POKER_Transfer_PlayerCard */
+#define POKER_STAT_OP       8
+
+/* counters of a deck, kept only if the library is built with POKER_STAT defined */
+typedef struct stat_s
+{
+    unsigned long long  calls[POKER_STAT_OP];   /* calls of every operation */
+    unsigned long long  ns[POKER_STAT_OP];      /* nanoseconds spent in every operation */
+    unsigned long long  walks;                  /* cards walked through in lists to reach an index */
+    unsigned long long  shifts;                 /* cards shifted in arrays to close a gap */
+    unsigned long long  compares;               /* calls of compare rule function */
+    unsigned long long  callbacks;              /* calls of search rule function */
+    unsigned long long  allocs;                 /* memory blocks allocated */
+} STAT_T;
+
+/* a hand of an archive, from POKER_Find_Hand, POKER_Find_HandTime and POKER_Next_Hand */
+typedef struct hand_s
+{
+    unsigned long long  hand_id;
+    unsigned long long  time;
+    int                 table;
+    const void          *data;      /* records of the hand for POKER_Replay_Log, in the archive */
+    size_t              size;
+} HAND_T;
+
 typedef struct card_s CARD_T;
 typedef struct pile_s PILE_T;
 typedef struct deck_s DECK_T;
 typedef DECK_T* DECK_TP;
+typedef struct archive_s ARCHIVE_T;
+typedef ARCHIVE_T* ARCHIVE_TP;
+
+/* a card of a list type pile, laid out here for the inline steps of a cursor */
+struct card_s
+{
+    int             card;
+    struct card_s   *next;
+    struct card_s   *prev;
+};
+
+/* cursor over the cards of a pile, from POKER_Begin_Cursor, index is read by caller */
+typedef struct cursor_s
+{
+    DECK_TP     deck;
+    PILE_T      *pile;
+    int         pile_no;
+    int         index;      /* index of the current card, or of the next card after it is removed */
+    int         card_num;   /* cards of the pile, 0 after POKER_End_Cursor */
+    int         gap;        /* cards removed from an array pile, closed as the cursor moves */
+    int         removed;    /* the current card is removed */
+    int         *slot;      /* ring buffer of an array pile, NULL for a list pile */
+    int         head;       /* slot of top card, array type */
+    int         mask;       /* slot capacity - 1, array type */
+    CARD_T      *node;      /* the current card of a list pile, or the next card after it is removed */
+} CURSOR_T;
 
 /* POKER_Color: check the color of card
     * parameter: int card -- the card
@@ -56,15 +171,224 @@ typedef DECK_T* DECK_TP;
     * comment: the number will be POKER_NUM_A ~ POKER_NUM_K */
 #define POKER_Num(card)   (POKER_MASK_NUM&card)
 
+/* POKER_Pack: check which pack of a shoe the card comes from
+    * parameter: int card -- the card
+    * comment: the pack will be 0 ~ packs - 1, cards of the first pack have no pack bits */
+#define POKER_Pack(card)  ((POKER_MASK_PACK&(card)) >> 8)
+
+/* POKER_PACK_CARD: the card of a pack
+    * parameter: int pack -- the pack
+                 int card -- the color and number of card */
+#define POKER_PACK_CARD(pack, card)  (((pack) << 8) | (card))
+
+/* POKER_Card_Bit: the bit of card in a card set
+    * parameter: int card -- the card */
+#define POKER_Card_Bit(card) ((POKER_Color((card)) == POKER_COLOR_JOKER) ? \
+                              (1ULL << (51 + POKER_Num((card)))) : \
+                              (1ULL << ((POKER_Color((card)) / 0x10 - 2) * 13 + POKER_Num((card)) - POKER_NUM_2)))
+
 /* POKER_Create_Deck: create a deck of poker, priority is from spade A to club K
    * paremeter: int players -- how many players
                 int joker_num -- how many joker cards
    * return value: the pointer to a deck of poker */
 DECK_TP POKER_Create_Deck(int players, int joker_num);
 
+/* POKER_Create_DeckEx: create a deck of poker with the pile storage type
+   * paremeter: int players -- how many players
+                int joker_num -- how many joker cards
+                int flag -- POKER_DECK_LIST or POKER_DECK_ARRAY, or'ed with POKER_DECK_CARDSET or POKER_DECK_PACK(n)
+   * return value: the pointer to a deck of poker
+   * comment: POKER_Create_Deck creates a POKER_DECK_LIST deck, all POKER_* functions work on both types */
+DECK_TP POKER_Create_DeckEx(int players, int joker_num, int flag);
+
+/* POKER_Get_DeckSize: get the memory size POKER_Init_Deck needs for a deck
+   * paremeter: int players -- how many players
+                int joker_num -- how many joker cards
+                int flag -- POKER_DECK_LIST or POKER_DECK_ARRAY, or'ed with POKER_DECK_CARDSET or POKER_DECK_PACK(n)
+   * return value: the size in bytes, 0 for invalid parameters */
+size_t POKER_Get_DeckSize(int players, int joker_num, int flag);
+
+/* POKER_Init_Deck: create a deck of poker in a caller supplied memory block
+   * paremeter: void *mem -- the memory block, aligned for a pointer
+                size_t size -- the size of memory block
+                int players -- how many players
+                int joker_num -- how many joker cards
+                int flag -- POKER_DECK_LIST or POKER_DECK_ARRAY, or'ed with POKER_DECK_CARDSET or POKER_DECK_PACK(n)
+                unsigned long long seed -- the seed of random number generator, as POKER_Seed_Deck
+   * return value: the pointer to a deck of poker, NULL if the block is too small
+   * comment: POKER_Delete_Deck on this deck does not free the memory block, OS entropy is not read */
+DECK_TP POKER_Init_Deck(void *mem, size_t size, int players, int joker_num, int flag, unsigned long long seed);
+
 /* POKER_Delete_Deck: delete a deck of poker */
 void POKER_Delete_Deck(DECK_TP *deck);
 
+/* POKER_Reset_Deck: collect all cards back to last pile for a new game, no memory is allocated
+   * parameter: DECK_TP deck -- the pointer to a deck of poker
+                int shuffle -- 0 for priority from spade A to club K, otherwise shuffle last pile
+   * return value: POKER_OK for success, POKER_ERR for fail */
+int POKER_Reset_Deck(DECK_TP deck, int shuffle);
+
+/* POKER_Seed_Deck: seed the random number generator of a deck, the same seed gives the same shuffles
+   * parameter: DECK_TP deck -- the pointer to a deck of poker
+                unsigned long long seed -- the seed
+   * return value: POKER_OK for success, POKER_ERR for fail */
+int POKER_Seed_Deck(DECK_TP deck, unsigned long long seed);
+
+/* POKER_Seed_DeckRandom: seed the random number generator of a deck from OS entropy,
+   * parameter: DECK_TP deck -- the pointer to a deck of poker
+   * return value: POKER_OK for success, POKER_ERR for fail
+   * comment: a deck of POKER_Create_Deck or POKER_Create_DeckEx is already seeded this way */
+int POKER_Seed_DeckRandom(DECK_TP deck);
+
+/* POKER_Rand_Deck: get a random number from the random number generator of a deck
+   * parameter: DECK_TP deck -- the pointer to a deck of poker
+                int range -- the range of random number
+   * return value: an unbiased random number from 0 to range - 1, POKER_ERR for fail */
+int POKER_Rand_Deck(DECK_TP deck, int range);
+
+/* POKER_Copy_DeckRandom: copy the random number generator of a deck to another deck of any players,
+   * parameter: DECK_TP to -- the pointer to a deck of poker
+                DECK_TP from -- the pointer to a deck of poker, not changed
+   * return value: POKER_OK for success, POKER_ERR for fail
+   * comment: random numbers of to are those from would give next */
+int POKER_Copy_DeckRandom(DECK_TP to, DECK_TP from);
+
+/* POKER_Set_CutCard: put the cut card into last pile, for a shoe to know when to reshuffle
+   * parameter: DECK_TP deck -- the pointer to a deck of poker
+                int index -- the cut card is in front of the card of index, 0 ~ card number of last pile
+   * return value: POKER_OK for success, POKER_ERR for fail
+   * comment: the cut card stays in place while cards are dealt from top, POKER_Reset_Deck puts it to the bottom */
+int POKER_Set_CutCard(DECK_TP deck, int index);
+
+/* POKER_Check_CutCard: check if the cut card is reached
+   * parameter: DECK_TP deck -- the pointer to a deck of poker
+   * return value: POKER_OK for reached, POKER_NONE for not yet, POKER_ERR for failure */
+int POKER_Check_CutCard(DECK_TP deck);
+
+/* POKER_Get_SnapshotSize: get the size of snapshot of a deck,
+   * parameter: DECK_TP deck -- the pointer to a deck of poker
+   * return value: the size in bytes, 0 for failure */
+size_t POKER_Get_SnapshotSize(DECK_TP deck);
+
+/* POKER_Save_Deck: save the cards of every pile, the cut card and random number generator of a deck,
+   * parameter: DECK_TP deck -- the pointer to a deck of poker
+                void *buf -- the snapshot
+                size_t size -- the size of buf, POKER_Get_SnapshotSize at least
+   * return value: the size of snapshot, POKER_ERR for fail
+   * comment: the snapshot has no pointer and is the same on every machine */
+int POKER_Save_Deck(DECK_TP deck, void *buf, size_t size);
+
+/* POKER_Load_Deck: restore a deck from a snapshot of POKER_Save_Deck, no memory is allocated
+   * parameter: DECK_TP deck -- the pointer to a deck of poker, with the same players, jokers and packs
+                               as the saved deck, of any pile storage type
+                const void *buf -- the snapshot
+                size_t size -- the size of buf
+   * return value: POKER_OK for success, POKER_ERR for fail, the deck is not changed if fail */
+int POKER_Load_Deck(DECK_TP deck, const void *buf, size_t size);
+
+/* POKER_Copy_Deck: copy the cards of every pile, the cut card and random number generator of a deck
+                    to another deck, no memory is allocated
+   * parameter: DECK_TP to -- the pointer to a deck of poker, with the same players, jokers and packs
+                DECK_TP from -- the pointer to a deck of poker
+   * return value: POKER_OK for success, POKER_ERR for fail
+   * comment: decks of the same storage type are copied in memory blocks */
+int POKER_Copy_Deck(DECK_TP to, DECK_TP from);
+
+/* POKER_Clone_Deck: create a deck of poker the same as another,
+   * parameter: DECK_TP deck -- the pointer to a deck of poker
+   * return value: the pointer to a new deck of poker, NULL for failure
+   * comment: the clone has the random number generator state of deck, OS entropy is not read */
+DECK_TP POKER_Clone_Deck(DECK_TP deck);
+
+/* POKER_Open_Log: log every change of a deck to a file descriptor, for POKER_Replay_Log
+   * parameter: DECK_TP deck -- the pointer to a deck of poker
+                int fd -- the file descriptor opened for writing by caller
+                size_t size -- the bytes buffered between writes, 0 for POKER_LOG_SIZE
+   * return value: POKER_OK for success, POKER_ERR for fail
+   * comment: the log starts with a snapshot of deck, records are written when the buffer is full
+              and by POKER_Flush_Log, POKER_Close_Log or POKER_Delete_Deck */
+int POKER_Open_Log(DECK_TP deck, int fd, size_t size);
+
+/* POKER_Flush_Log: write the buffered records of log,
+   * parameter: DECK_TP deck -- the pointer to a deck of poker
+   * return value: POKER_OK for success, POKER_ERR for fail or a write failed since the log is opened */
+int POKER_Flush_Log(DECK_TP deck);
+
+/* POKER_Close_Log: write the buffered records and stop logging, the file descriptor is not closed
+   * parameter: DECK_TP deck -- the pointer to a deck of poker
+   * return value: POKER_OK for success, POKER_ERR for fail or a write failed since the log is opened */
+int POKER_Close_Log(DECK_TP deck);
+
+/* POKER_Replay_Log: apply the records of a log to a deck,
+   * parameter: DECK_TP deck -- the pointer to a deck of poker, with the same players, jokers and packs
+                               as the logged deck
+                const void *buf -- the records of POKER_Open_Log
+                size_t size -- the size of buf
+                int max -- the most records to apply, < 0 for all
+                size_t *used -- the bytes of records applied, could be NULL
+   * return value: the number of records applied, POKER_ERR for a bad record or a failed operation
+   * comment: a record cut at the end of buf is left, a log starts with a snapshot of the whole deck */
+int POKER_Replay_Log(DECK_TP deck, const void *buf, size_t size, int max, size_t *used);
+
+/* POKER_Mark_Hand: mark the start of a hand in the log of deck, for POKER_Write_Archive
+   * parameter: DECK_TP deck -- the pointer to a deck of poker with a log
+                unsigned long long hand_id -- the id of hand
+                unsigned long long time -- the time of hand, in any unit of caller
+                int table -- the table of hand, >= 0
+   * return value: POKER_OK for success, POKER_ERR for fail
+   * comment: a snapshot of deck follows the mark, so a hand is replayed without the records before it */
+int POKER_Mark_Hand(DECK_TP deck, unsigned long long hand_id, unsigned long long time, int table);
+
+/* POKER_Write_Archive: write the hands of a log as an archive, for POKER_Open_Archive
+   * parameter: int fd -- the file descriptor opened for writing by caller
+                const void *log -- the records of POKER_Open_Log, hands marked by POKER_Mark_Hand
+                size_t size -- the size of log
+                int step -- hands of every index entry, 0 for POKER_ARCHIVE_STEP
+   * return value: POKER_OK for success, POKER_ERR for fail
+   * comment: hands must be in order of id, and of time, records before the first hand are left,
+              the last hand ends at the end of log */
+int POKER_Write_Archive(int fd, const void *log, size_t size, int step);
+
+/* POKER_Open_Archive: map an archive of POKER_Write_Archive for reading,
+   * parameter: const char *path -- the file of archive
+   * return value: the pointer to the archive, NULL for failure
+   * comment: the file is not read but the head, hands are read in place when they are found */
+ARCHIVE_TP POKER_Open_Archive(const char *path);
+
+/* POKER_Close_Archive: unmap an archive,
+   * parameter: ARCHIVE_TP *archive -- the pointer to the archive, set to NULL
+   * comment: hands found in the archive can not be used after it is closed */
+void POKER_Close_Archive(ARCHIVE_TP *archive);
+
+/* POKER_Get_HandNum: get the number of hands in an archive,
+   * parameter: ARCHIVE_TP archive -- the pointer to the archive
+   * return value: the number of hands, POKER_ERR for fail */
+long long POKER_Get_HandNum(ARCHIVE_TP archive);
+
+/* POKER_Find_Hand: find a hand by its id,
+   * parameter: ARCHIVE_TP archive -- the pointer to the archive
+                unsigned long long hand_id -- the id of hand
+                HAND_T *hand -- the hand found, its records are in the archive
+   * return value: POKER_OK for found, POKER_NONE for not found, POKER_ERR for fail
+   * comment: the index is searched in O(log n), then the hands of an entry one by one */
+int POKER_Find_Hand(ARCHIVE_TP archive, unsigned long long hand_id, HAND_T *hand);
+
+/* POKER_Find_HandTime: find the first hand at or after a time,
+   * parameter: ARCHIVE_TP archive -- the pointer to the archive
+                unsigned long long time -- the time
+                HAND_T *hand -- the hand found, its records are in the archive
+   * return value: POKER_OK for found, POKER_NONE for no hand at or after time, POKER_ERR for fail */
+int POKER_Find_HandTime(ARCHIVE_TP archive, unsigned long long time, HAND_T *hand);
+
+/* POKER_Next_Hand: scan the hands of an archive in order,
+   * parameter: ARCHIVE_TP archive -- the pointer to the archive
+                int table -- the table of hands, -1 for all tables
+                HAND_T *hand -- the hand before, its data NULL to start from the first hand,
+                                the next hand when found
+   * return value: POKER_OK for found, POKER_NONE for no more hand, POKER_ERR for fail
+   * comment: index entries without table are skipped */
+int POKER_Next_Hand(ARCHIVE_TP archive, int table, HAND_T *hand);
+
 /* POKER_Get_TotalCardNum: get total card number,
    * parameter: DECK_TP deck -- the pointer to a deck of poker
    * return value: the total card number    */
@@ -116,6 +440,26 @@ int POKER_Show_PlayerCard(DECK_TP deck, int player_no, int type, int index);
    * return value: POKER_OK for success, POKER_ERR for fail */
 int POKER_Deal_Card(DECK_TP deck, int type, int index, int player_no);
 
+/* POKER_Deal_Cards: deal cards from top of last_pile to a player,
+   * parameter: DECK_TP deck -- the pointer to a deck of poker
+                int num -- how many cards
+                int player_no -- the player no
+   * return value: POKER_OK for success, POKER_ERR for fail, no card is dealt if fail */
+int POKER_Deal_Cards(DECK_TP deck, int num, int player_no);
+
+/* POKER_Deal_Round: deal cards from top of last_pile to every player in turn,
+   * parameter: DECK_TP deck -- the pointer to a deck of poker
+                int num -- how many cards for every player
+                int first_player -- the player no who gets the first card
+   * return value: POKER_OK for success, POKER_ERR for fail, no card is dealt if fail */
+int POKER_Deal_Round(DECK_TP deck, int num, int first_player);
+
+/* POKER_Deal_All: deal all cards of last_pile to every player in turn,
+   * parameter: DECK_TP deck -- the pointer to a deck of poker
+                int first_player -- the player no who gets the first card
+   * return value: POKER_OK for success, POKER_ERR for fail */
+int POKER_Deal_All(DECK_TP deck, int first_player);
+
 /* POKER_Transfer_PlayerCard: transfer a card from a player to another,
    * parameter: DECK_TP deck -- the pointer to a deck of poker
                 int type -- from top, bottom or index of last_pile
@@ -140,6 +484,35 @@ int POKER_Throw_LastCard(DECK_TP deck, int type, int index);
    * return value: POKER_OK for success, POKER_ERR for fail */
 int POKER_Throw_PlayerCard(DECK_TP deck, int player_no, int type, int index);
 
+/* POKER_Throw_PlayerPair: throw all pairs of the same number from player to trash_pile,
+   * parameter: DECK_TP deck -- the pointer to a deck of poker
+                int player_no -- the player no
+                int *cards -- the thrown cards in order, could be NULL
+                int max -- the size of cards
+   * return value: the number of thrown cards, POKER_ERR for fail
+   * comment: cards are paired from top of pile, the last card of an odd count is kept, jokers are not paired */
+int POKER_Throw_PlayerPair(DECK_TP deck, int player_no, int *cards, int max);
+
+/* POKER_Move_Pile: move all cards of a pile onto another pile,
+   * parameter: DECK_TP deck -- the pointer to a deck of poker
+                int from_pile_no -- the player no, POKER_PILE_LAST or POKER_PILE_TRASH
+                int to_pile_no -- the player no, POKER_PILE_LAST or POKER_PILE_TRASH
+                int type -- onto top or bottom of to_pile
+   * return value: POKER_OK for success, POKER_ERR for fail
+   * comment: the order of cards is kept, it takes O(1) for list type */
+int POKER_Move_Pile(DECK_TP deck, int from_pile_no, int to_pile_no, int type);
+
+/* POKER_Move_PileRange: move cards of index ~ index + num - 1 of a pile onto another pile,
+   * parameter: DECK_TP deck -- the pointer to a deck of poker
+                int from_pile_no -- the player no, POKER_PILE_LAST or POKER_PILE_TRASH
+                int index -- the index of first card
+                int num -- how many cards
+                int to_pile_no -- the player no, POKER_PILE_LAST or POKER_PILE_TRASH
+                int type -- onto top or bottom of to_pile
+   * return value: POKER_OK for success, POKER_ERR for fail
+   * comment: the order of cards is kept */
+int POKER_Move_PileRange(DECK_TP deck, int from_pile_no, int index, int num, int to_pile_no, int type);
+
 /* POKER_Dump_PlayerPile: dump a player's pile, the way appointed in dump_func
    * parameter: DECK_TP deck -- the pointer to a deck of poker
                 int player_no -- the player no.
@@ -187,6 +560,19 @@ int POKER_Sort_TrashPile(DECK_TP deck, int (*comp_func)(int card1, int card2));
    * return value: POKER_OK for success, POKER_ERR for fail */
 int POKER_Sort_PlayerPile(DECK_TP deck, int player_no, int (*comp_func)(int card1, int card2));
 
+/* POKER_Comp_ColorNum: compare rule of spade A ~ K, heart A ~ K, diamond A ~ K, club A ~ K and jokers
+   * comment: sorting with this rule is in linear time, so are the other POKER_Comp_* rules */
+int POKER_Comp_ColorNum(int card1, int card2);
+
+/* POKER_Comp_ColorNumAceHigh: compare rule of spade 2 ~ A, heart 2 ~ A, diamond 2 ~ A, club 2 ~ A and jokers */
+int POKER_Comp_ColorNumAceHigh(int card1, int card2);
+
+/* POKER_Comp_NumColor: compare rule of A ~ K, the same number from spade to club, and jokers */
+int POKER_Comp_NumColor(int card1, int card2);
+
+/* POKER_Comp_NumColorAceHigh: compare rule of 2 ~ A, the same number from spade to club, and jokers */
+int POKER_Comp_NumColorAceHigh(int card1, int card2);
+
 /* POKER_Shuffle_LastPile: shuffle last pile
    * parameter: DECK_TP deck -- the pointer to a deck of poker
    * return value: POKER_OK for success, POKER_ERR for fail */
@@ -229,5 +615,202 @@ int POKER_Search_LastPile(DECK_TP deck, int (*search_func)(int index, int card,
    * comment: if the search func return POKER_OK, means found and function will return, else keep loop searching    */
 int POKER_Search_TrashPile(DECK_TP deck, int (*search_func)(int index, int card, void *para), void *para);
 
+/* POKER_Begin_Cursor: start a cursor at the top card of a pile,
+   * parameter: DECK_TP deck -- the pointer to a deck of poker
+                int pile_no -- the player no, POKER_PILE_LAST or POKER_PILE_TRASH
+                CURSOR_T *cursor -- the cursor
+   * return value: the top card, POKER_NONE for an empty pile, POKER_ERR for fail
+   * comment: a deck has one cursor at most, till POKER_End_Cursor the deck is changed only by the cursor and
+              every other call on the deck fails, POKER_Delete_Deck excepted */
+int POKER_Begin_Cursor(DECK_TP deck, int pile_no, CURSOR_T *cursor);
+
+/* POKER_Step_Cursor: move a cursor to the next card, POKER_Next_Cursor without its inline steps,
+   * parameter: CURSOR_T *cursor -- the cursor
+   * return value: the next card, POKER_NONE for the end of pile, POKER_ERR for fail */
+int POKER_Step_Cursor(CURSOR_T *cursor);
+
+/* POKER_Next_Cursor: move a cursor to the next card,
+   * parameter: CURSOR_T *cursor -- the cursor
+   * return value: the next card, POKER_NONE for the end of pile, POKER_ERR for fail
+   * comment: a step inside the pile is inline, POKER_Step_Cursor takes a removed card and the end of pile */
+static inline int POKER_Next_Cursor(CURSOR_T *cursor)
+{
+    int *slot = NULL;
+
+    if ((cursor == NULL) || cursor->removed || (cursor->index + 1 >= cursor->card_num)) return POKER_Step_Cursor(cursor);
+    if ((slot = cursor->slot) == NULL)
+    {
+        cursor->index++;
+        cursor->node = cursor->node->next;
+        return cursor->node->card;
+    }
+
+    /* the card kept is moved over the gap */
+    if (cursor->gap > 0)
+        slot[(cursor->head + cursor->index) & cursor->mask] = slot[(cursor->head + cursor->index + cursor->gap) & cursor->mask];
+    cursor->index++;
+    return slot[(cursor->head + cursor->index + cursor->gap) & cursor->mask];
+}
+
+/* POKER_Get_CursorCard: get the current card of a cursor,
+   * parameter: CURSOR_T *cursor -- the cursor
+   * return value: the card, POKER_NONE if it is removed or at the end of pile, POKER_ERR for fail */
+static inline int POKER_Get_CursorCard(CURSOR_T *cursor)
+{
+    if ((cursor == NULL) || (cursor->deck == NULL)) return POKER_ERR;
+    if (cursor->removed || (cursor->index >= cursor->card_num)) return POKER_NONE;
+    if (cursor->slot == NULL) return cursor->node->card;
+    return cursor->slot[(cursor->head + cursor->index + cursor->gap) & cursor->mask];
+}
+
+/* POKER_Remove_CursorCard: move the current card of a cursor to the bottom of another pile,
+   * parameter: CURSOR_T *cursor -- the cursor
+                int to_pile_no -- the player no, POKER_PILE_LAST or POKER_PILE_TRASH
+   * return value: POKER_OK for success, POKER_ERR for fail
+   * comment: it takes O(1), POKER_Next_Cursor moves to the card after it, the same as
+              POKER_Move_PileRange of the card to the bottom */
+int POKER_Remove_CursorCard(CURSOR_T *cursor, int to_pile_no);
+
+/* POKER_End_Cursor: stop a cursor,
+   * parameter: CURSOR_T *cursor -- the cursor
+   * return value: POKER_OK for success, POKER_ERR for fail
+   * comment: the gap left by cards removed from an array pile is closed and the deck takes other calls again */
+int POKER_End_Cursor(CURSOR_T *cursor);
+
+/* POKER_Get_PileCards: copy the cards of a pile from top,
+   * parameter: DECK_TP deck -- the pointer to a deck of poker
+                int pile_no -- the player no, POKER_PILE_LAST or POKER_PILE_TRASH
+                int *cards -- the cards, could be NULL
+                int max -- the most cards to copy
+   * return value: the card number of pile, POKER_ERR for fail */
+int POKER_Get_PileCards(DECK_TP deck, int pile_no, int *cards, int max);
+
+/* POKER_Get_CardSet: get the card set of a pile,
+   * parameter: DECK_TP deck -- the pointer to a deck of poker, created with POKER_DECK_CARDSET
+                int pile_no -- the player no, POKER_PILE_LAST or POKER_PILE_TRASH
+                CARDSET_T *set -- the card set of pile
+   * return value: POKER_OK for success, POKER_ERR for fail */
+int POKER_Get_CardSet(DECK_TP deck, int pile_no, CARDSET_T *set);
+
+/* POKER_Has_Card: check if a pile has a card,
+   * parameter: DECK_TP deck -- the pointer to a deck of poker, created with POKER_DECK_CARDSET
+                int pile_no -- the player no, POKER_PILE_LAST or POKER_PILE_TRASH
+                int card -- the card
+   * return value: POKER_OK for found, POKER_NONE for none, POKER_ERR for failure */
+int POKER_Has_Card(DECK_TP deck, int pile_no, int card);
+
+/* POKER_Count_NumCard: count the cards of a number in a pile,
+   * parameter: DECK_TP deck -- the pointer to a deck of poker, created with POKER_DECK_CARDSET
+                int pile_no -- the player no, POKER_PILE_LAST or POKER_PILE_TRASH
+                int num -- POKER_NUM_2 ~ POKER_NUM_A
+   * return value: the card number, POKER_ERR for failure */
+int POKER_Count_NumCard(DECK_TP deck, int pile_no, int num);
+
+/* POKER_Count_ColorCard: count the cards of a color in a pile,
+   * parameter: DECK_TP deck -- the pointer to a deck of poker, created with POKER_DECK_CARDSET
+                int pile_no -- the player no, POKER_PILE_LAST or POKER_PILE_TRASH
+                int color -- POKER_COLOR_SPADE ~ POKER_COLOR_JOKER
+   * return value: the card number, POKER_ERR for failure */
+int POKER_Count_ColorCard(DECK_TP deck, int pile_no, int color);
+
+/* POKER_And_CardSet: get the cards both in two piles,
+   * parameter: DECK_TP deck -- the pointer to a deck of poker, created with POKER_DECK_CARDSET
+                int pile_no1 -- the player no, POKER_PILE_LAST or POKER_PILE_TRASH
+                int pile_no2 -- the player no, POKER_PILE_LAST or POKER_PILE_TRASH
+                CARDSET_T *set -- the intersection of two card sets
+   * return value: POKER_OK for success, POKER_ERR for fail */
+int POKER_And_CardSet(DECK_TP deck, int pile_no1, int pile_no2, CARDSET_T *set);
+
+/* POKER_Or_CardSet: get the cards in either of two piles,
+   * parameter: DECK_TP deck -- the pointer to a deck of poker, created with POKER_DECK_CARDSET
+                int pile_no1 -- the player no, POKER_PILE_LAST or POKER_PILE_TRASH
+                int pile_no2 -- the player no, POKER_PILE_LAST or POKER_PILE_TRASH
+                CARDSET_T *set -- the union of two card sets
+   * return value: POKER_OK for success, POKER_ERR for fail */
+int POKER_Or_CardSet(DECK_TP deck, int pile_no1, int pile_no2, CARDSET_T *set);
+
+/* POKER_Get_DeckStat: get the counters of a deck since it is created or reset,
+   * parameter: DECK_TP deck -- the pointer to a deck of poker
+                STAT_T *stat -- the counters
+   * return value: POKER_OK for success, POKER_NONE if the library is built without POKER_STAT,
+                   POKER_ERR for fail
+   * comment: counters cost nothing if POKER_STAT is not defined */
+int POKER_Get_DeckStat(DECK_TP deck, STAT_T *stat);
+
+/* POKER_Reset_DeckStat: clear the counters of a deck,
+   * parameter: DECK_TP deck -- the pointer to a deck of poker
+   * return value: POKER_OK for success, POKER_NONE if the library is built without POKER_STAT,
+                   POKER_ERR for fail */
+int POKER_Reset_DeckStat(DECK_TP deck);
+
+/* POKER_Eval_Hand: evaluate a poker hand of 5 ~ 7 cards with the best 5 cards of it,
+   * parameter: const int *cards -- the cards, no joker and no same card twice
+                int num -- the card number, 5 ~ 7
+   * return value: the value of hand from 1 to 7462, a better hand has a bigger value,
+                   POKER_ERR for failure
+   * comment: tables of evaluator are read only data generated at build time, it is thread safe */
+int POKER_Eval_Hand(const int *cards, int num);
+
+/* POKER_Eval_Batch: evaluate many hands of 7 cards,
+   * parameter: const int *cards -- 7 cards of every hand one after another
+                int num -- the number of hands
+                int *values -- the value of every hand as POKER_Eval_Hand
+   * return value: POKER_OK for success, POKER_ERR for fail
+   * comment: AVX2 evaluates 8 hands at a time if the CPU has it */
+int POKER_Eval_Batch(const int *cards, int num, int *values);
+
+/* POKER_Eval_PlayerHand: evaluate the cards of a player with community cards,
+   * parameter: DECK_TP deck -- the pointer to a deck of poker
+                int player_no -- the player no
+                const int *board -- the community cards, NULL for none
+                int board_num -- the number of community cards
+   * return value: the value of hand as POKER_Eval_Hand, POKER_ERR for failure */
+int POKER_Eval_PlayerHand(DECK_TP deck, int player_no, const int *board, int board_num);
+
+/* POKER_Hand_Type: get the hand type of a value from POKER_Eval_Hand,
+   * parameter: int value -- the value of hand
+   * return value: POKER_HAND_HIGH_CARD ~ POKER_HAND_STRAIGHT_FLUSH, POKER_ERR for failure */
+int POKER_Hand_Type(int value);
+
+/* POKER_Calc_Equity: calculate the equity of Texas Hold'em players by dealing the board,
+   * parameter: DECK_TP deck -- the pointer to a deck of poker, 2 ~ 10 players with 2 hole cards each,
+                                the board is dealt from last_pile
+                const int *board -- the community cards known, NULL for none
+                int board_num -- the number of community cards known, 0 ~ 5
+                int trials -- 0 for all boards, or the most boards of Monte Carlo sampling
+                double std_err -- Monte Carlo stops when the standard error of every equity is
+                                  under it, 0 for all trials
+                int threads -- the number of threads, 0 for all cores
+                EQUITY_T *equity -- the result
+   * return value: POKER_OK for success, POKER_ERR for fail
+   * comment: cards not in last_pile are dead, the deck is not changed, a copy of its random number
+              generator seeds Monte Carlo, there is no memory allocation */
+int POKER_Calc_Equity(DECK_TP deck, const int *board, int board_num, int trials, double std_err,
+                      int threads, EQUITY_T *equity);
+
+/* POKER_Parse_Range: parse a hand range of Texas Hold'em, as "QQ+, AKs, 76s-54s:0.5",
+   * parameter: const char *text -- the range
+                RANGE_T *range -- the combinations of range
+   * return value: POKER_OK for success, POKER_ERR for fail */
+int POKER_Parse_Range(const char *text, RANGE_T *range);
+
+/* POKER_Calc_RangeEquity: calculate the equity of Texas Hold'em ranges over their matchups,
+   * parameter: DECK_TP deck -- the pointer to a deck of poker, the board is dealt from last_pile
+                const RANGE_T *range -- the range of every seat, from POKER_Parse_Range
+                int range_num -- the number of seats, 2 ~ 10
+                const int *board -- the community cards known, NULL for none
+                int board_num -- the number of community cards known, 0 ~ 5
+                int trials -- 0 for all boards of every matchup, or boards of Monte Carlo sampling
+                              of every matchup
+                int threads -- the number of threads, 0 for all cores
+                EQUITY_T *equity -- the result, total is the number of matchups, equity is weighted
+                                    by the weights of combinations, win and tie are not counted
+   * return value: POKER_OK for success, POKER_ERR for fail or no matchup
+   * comment: combinations with a card not in last_pile or on board are removed, a matchup
+              same with another after exchanging colors is calculated once, ranges whose numbers
+              of combinations multiply to more than POKER_RANGE_MATCHUP are refused */
+int POKER_Calc_RangeEquity(DECK_TP deck, const RANGE_T *range, int range_num, const int *board, int board_num,
+                           int trials, int threads, EQUITY_T *equity);
+
 #endif
 
@@ -0,0 +1,398 @@
+/* archive of deck logs
+   * an archive is a file of the hands of a log, cut at its POKER_Mark_Hand records and read in place
+     from a memory map:
+     0   "PKA1" and 4 bytes of 0
+     8   hand number, 8 bytes
+     16  offset of index, 8 bytes
+     24  index entries and hands of an entry, 4 bytes each
+     32  hands, every hand: id and time in 8 bytes, table and size of records in 4 bytes, then records
+         of the hand from its snapshot
+     then index, an entry every step hands: id, time and offset of its first hand in 8 bytes, the
+         smallest and biggest table of its hands in 4 bytes
+   * numbers are little endian, hands are in order of id and time */
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "poker.h"
+#include "poker_log.h"
+
+#define ARCHIVE_MAGIC       "PKA1"
+#define ARCHIVE_HEAD_SIZE   32
+#define ARCHIVE_HAND_HEAD   24
+#define ARCHIVE_ENTRY_SIZE  32
+
+struct archive_s
+{
+    const unsigned char *map;
+    size_t              size;
+    uint64_t            hand_num;
+    uint64_t            hand_end;       /* offset of index, hands are before it */
+    const unsigned char *index;
+    unsigned int        entry_num;
+    unsigned int        step;
+};
+
+/* a hand of a log */
+typedef struct log_hand_s
+{
+    uint64_t            hand_id;
+    uint64_t            time;
+    unsigned int        table;
+    const unsigned char *data;
+    size_t              size;
+} LOG_HAND_T;
+
+/* output of archive, small pieces are gathered in buf */
+typedef struct archive_out_s
+{
+    int                 fd;
+    int                 err;
+    size_t              len;
+    unsigned char       buf[POKER_LOG_SIZE];
+} ARCHIVE_OUT_T;
+
+/* the next hand of log from pos, POKER_OK for a hand, POKER_NONE for no more, POKER_ERR for a bad record,
+   records before the first hand are skipped and the hand ends at the next hand or a record cut at the end */
+static int next_log_hand(const unsigned char *log, size_t size, size_t *pos, LOG_HAND_T *hand)
+{
+    long    len = 0;
+    int     found = 0;
+
+    while (*pos < size)
+    {
+        if ((len = log_record_size(log + *pos, size - *pos)) < 0) return POKER_ERR;
+        if (len == 0) break;
+        if (log[*pos] == LOG_HAND)
+        {
+            if (found) break;
+            found = 1;
+            hand->hand_id = get_64(log + *pos + 1);
+            hand->time = get_64(log + *pos + 9);
+            hand->table = get_32(log + *pos + 17);
+            hand->data = log + *pos + len;
+            hand->size = 0;
+        }
+        else if (found)
+        {
+            hand->size += len;
+        }
+        *pos += len;
+    }
+    return found ? POKER_OK : POKER_NONE;
+}
+
+static void out_write(ARCHIVE_OUT_T *out, const unsigned char *data, size_t size)
+{
+    size_t  done = 0;
+    ssize_t num = 0;
+
+    while ((done < size) && !out->err)
+    {
+        num = write(out->fd, data + done, size - done);
+        if ((num < 0) && (errno == EINTR)) continue;
+        if (num <= 0) out->err = 1;
+        else done += num;
+    }
+}
+
+static void out_flush(ARCHIVE_OUT_T *out)
+{
+    out_write(out, out->buf, out->len);
+    out->len = 0;
+}
+
+static void out_put(ARCHIVE_OUT_T *out, const unsigned char *data, size_t size)
+{
+    if (out->len + size > sizeof(out->buf)) out_flush(out);
+    if (size > sizeof(out->buf))
+    {
+        out_write(out, data, size);
+        return;
+    }
+    memcpy(out->buf + out->len, data, size);
+    out->len += size;
+}
+
+/* POKER_Write_Archive: write the hands of a log as an archive, for POKER_Open_Archive
+   * parameter: int fd -- the file descriptor opened for writing by caller
+                const void *log -- the records of POKER_Open_Log, hands marked by POKER_Mark_Hand
+                size_t size -- the size of log
+                int step -- hands of every index entry, 0 for POKER_ARCHIVE_STEP
+   * return value: POKER_OK for success, POKER_ERR for fail
+   * comment: hands must be in order of id, and of time, records before the first hand are left,
+              the last hand ends at the end of log */
+int POKER_Write_Archive(int fd, const void *log, size_t size, int step)
+{
+    ARCHIVE_OUT_T   *out = NULL;
+    LOG_HAND_T      hand;
+    unsigned char   *index = NULL;
+    unsigned char   *entry = NULL;
+    unsigned char   head[ARCHIVE_HEAD_SIZE];
+    uint64_t        hand_num = 0;
+    uint64_t        offset = ARCHIVE_HEAD_SIZE;
+    uint64_t        last_id = 0;
+    uint64_t        last_time = 0;
+    size_t          entry_num = 0;
+    size_t          entry_max = 0;
+    size_t          pos = 0;
+    int             rv = POKER_OK;
+
+    if ((fd < 0) || ((log == NULL) && (size > 0)) || (step < 0)) return POKER_ERR;
+    if (step == 0) step = POKER_ARCHIVE_STEP;
+
+    /* the index is made before hands are written, for its offset in head */
+    while ((rv = next_log_hand(log, size, &pos, &hand)) == POKER_OK)
+    {
+        if ((hand_num > 0) && ((hand.hand_id <= last_id) || (hand.time < last_time))) break;
+        if ((hand.table > INT32_MAX) || (hand.size > UINT32_MAX)) break;
+        last_id = hand.hand_id;
+        last_time = hand.time;
+        if (hand_num % step == 0)
+        {
+            if (entry_num == entry_max)
+            {
+                entry_max = entry_max ? entry_max * 2 : 64;
+                if ((entry = realloc(index, entry_max * ARCHIVE_ENTRY_SIZE)) == NULL) break;
+                index = entry;
+            }
+            entry = index + entry_num++ * ARCHIVE_ENTRY_SIZE;
+            put_64(entry, hand.hand_id);
+            put_64(entry + 8, hand.time);
+            put_64(entry + 16, offset);
+            put_32(entry + 24, hand.table);
+            put_32(entry + 28, hand.table);
+        }
+        if (hand.table < get_32(entry + 24)) put_32(entry + 24, hand.table);
+        if (hand.table > get_32(entry + 28)) put_32(entry + 28, hand.table);
+        offset += ARCHIVE_HAND_HEAD + hand.size;
+        hand_num++;
+    }
+    if ((rv != POKER_NONE) || (entry_num > UINT32_MAX) || ((out = malloc(sizeof(ARCHIVE_OUT_T))) == NULL))
+    {
+        free(index);
+        return POKER_ERR;
+    }
+
+    out->fd = fd;
+    out->err = 0;
+    out->len = 0;
+    memset(head, 0, sizeof(head));
+    memcpy(head, ARCHIVE_MAGIC, 4);
+    put_64(head + 8, hand_num);
+    put_64(head + 16, offset);
+    put_32(head + 24, (unsigned int)entry_num);
+    put_32(head + 28, (unsigned int)step);
+    out_put(out, head, ARCHIVE_HEAD_SIZE);
+    for (pos = 0; next_log_hand(log, size, &pos, &hand) == POKER_OK; )
+    {
+        put_64(head, hand.hand_id);
+        put_64(head + 8, hand.time);
+        put_32(head + 16, hand.table);
+        put_32(head + 20, (unsigned int)hand.size);
+        out_put(out, head, ARCHIVE_HAND_HEAD);
+        out_put(out, hand.data, hand.size);
+    }
+    if (entry_num > 0) out_put(out, index, entry_num * ARCHIVE_ENTRY_SIZE);
+    out_flush(out);
+
+    rv = out->err ? POKER_ERR : POKER_OK;
+    free(out);
+    free(index);
+    return rv;
+}
+
+/* POKER_Open_Archive: map an archive of POKER_Write_Archive for reading,
+   * parameter: const char *path -- the file of archive
+   * return value: the pointer to the archive, NULL for failure
+   * comment: the file is not read but the head, hands are read in place when they are found */
+ARCHIVE_TP POKER_Open_Archive(const char *path)
+{
+    ARCHIVE_T           *archive = NULL;
+    const unsigned char *map = NULL;
+    struct stat         st;
+    uint64_t            hand_end = 0;
+    int                 fd = -1;
+
+    if (path == NULL) return NULL;
+    if ((fd = open(path, O_RDONLY)) < 0) return NULL;
+    if ((fstat(fd, &st) != 0) || (st.st_size < ARCHIVE_HEAD_SIZE))
+    {
+        close(fd);
+        return NULL;
+    }
+    map = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) return NULL;
+
+    hand_end = get_64(map + 16);
+    if ((memcmp(map, ARCHIVE_MAGIC, 4) != 0) || (hand_end < ARCHIVE_HEAD_SIZE) ||
+        (hand_end + (uint64_t)get_32(map + 24) * ARCHIVE_ENTRY_SIZE != (uint64_t)st.st_size) ||
+        (get_32(map + 28) == 0) ||
+        ((uint64_t)get_32(map + 24) != (get_64(map + 8) + get_32(map + 28) - 1) / get_32(map + 28)) ||
+        ((archive = malloc(sizeof(ARCHIVE_T))) == NULL))
+    {
+        munmap((void *)map, st.st_size);
+        return NULL;
+    }
+
+    archive->map = map;
+    archive->size = st.st_size;
+    archive->hand_num = get_64(map + 8);
+    archive->hand_end = hand_end;
+    archive->index = map + hand_end;
+    archive->entry_num = get_32(map + 24);
+    archive->step = get_32(map + 28);
+    return archive;
+}
+
+/* POKER_Close_Archive: unmap an archive,
+   * parameter: ARCHIVE_TP *archive -- the pointer to the archive, set to NULL
+   * comment: hands found in the archive can not be used after it is closed */
+void POKER_Close_Archive(ARCHIVE_TP *archive)
+{
+    if ((archive == NULL) || (*archive == NULL)) return;
+    munmap((void *)(*archive)->map, (*archive)->size);
+    free(*archive);
+    *archive = NULL;
+}
+
+/* POKER_Get_HandNum: get the number of hands in an archive,
+   * parameter: ARCHIVE_TP archive -- the pointer to the archive
+   * return value: the number of hands, POKER_ERR for fail */
+long long POKER_Get_HandNum(ARCHIVE_TP archive)
+{
+    if (archive == NULL) return POKER_ERR;
+    return (long long)archive->hand_num;
+}
+
+/* the hand at offset, POKER_ERR if it is out of the hands */
+static int read_hand(ARCHIVE_T *archive, uint64_t offset, HAND_T *hand)
+{
+    const unsigned char *head = archive->map + offset;
+    uint64_t            size = 0;
+
+    if ((offset < ARCHIVE_HEAD_SIZE) || (offset + ARCHIVE_HAND_HEAD > archive->hand_end)) return POKER_ERR;
+    size = get_32(head + 20);
+    if (size > archive->hand_end - offset - ARCHIVE_HAND_HEAD) return POKER_ERR;
+    hand->hand_id = get_64(head);
+    hand->time = get_64(head + 8);
+    hand->table = (int)get_32(head + 16);
+    hand->data = head + ARCHIVE_HAND_HEAD;
+    hand->size = size;
+    return POKER_OK;
+}
+
+static uint64_t entry_offset(ARCHIVE_T *archive, unsigned int entry)
+{
+    if (entry >= archive->entry_num) return archive->hand_end;
+    return get_64(archive->index + (size_t)entry * ARCHIVE_ENTRY_SIZE + 16);
+}
+
+/* the first index entry with the 8 bytes at field bigger than value, entries are in order of it */
+static unsigned int find_entry(ARCHIVE_T *archive, int field, uint64_t value)
+{
+    unsigned int low = 0;
+    unsigned int high = archive->entry_num;
+    unsigned int mid = 0;
+
+    while (low < high)
+    {
+        mid = low + (high - low) / 2;
+        if (get_64(archive->index + (size_t)mid * ARCHIVE_ENTRY_SIZE + field) > value) high = mid;
+        else low = mid + 1;
+    }
+    return low;
+}
+
+/* POKER_Find_Hand: find a hand by its id,
+   * parameter: ARCHIVE_TP archive -- the pointer to the archive
+                unsigned long long hand_id -- the id of hand
+                HAND_T *hand -- the hand found, its records are in the archive
+   * return value: POKER_OK for found, POKER_NONE for not found, POKER_ERR for fail
+   * comment: the index is searched in O(log n), then the hands of an entry one by one */
+int POKER_Find_Hand(ARCHIVE_TP archive, unsigned long long hand_id, HAND_T *hand)
+{
+    uint64_t        offset = 0;
+    uint64_t        end = 0;
+    unsigned int    entry = 0;
+
+    if ((archive == NULL) || (hand == NULL)) return POKER_ERR;
+    if ((entry = find_entry(archive, 0, hand_id)) == 0) return POKER_NONE;
+
+    end = entry_offset(archive, entry);
+    for (offset = entry_offset(archive, entry - 1); offset < end; offset += ARCHIVE_HAND_HEAD + hand->size)
+    {
+        if (read_hand(archive, offset, hand) != POKER_OK) return POKER_ERR;
+        if (hand->hand_id == hand_id) return POKER_OK;
+        if (hand->hand_id > hand_id) break;
+    }
+    return POKER_NONE;
+}
+
+/* POKER_Find_HandTime: find the first hand at or after a time,
+   * parameter: ARCHIVE_TP archive -- the pointer to the archive
+                unsigned long long time -- the time
+                HAND_T *hand -- the hand found, its records are in the archive
+   * return value: POKER_OK for found, POKER_NONE for no hand at or after time, POKER_ERR for fail */
+int POKER_Find_HandTime(ARCHIVE_TP archive, unsigned long long time, HAND_T *hand)
+{
+    uint64_t        offset = 0;
+    unsigned int    entry = 0;
+
+    if ((archive == NULL) || (hand == NULL)) return POKER_ERR;
+    if (time == 0) entry = 0;
+    else if ((entry = find_entry(archive, 8, time - 1)) > 0) entry--;
+
+    /* the hand is in the entry before the first one from time, or it is the first hand of that one */
+    for (offset = entry_offset(archive, entry); offset < archive->hand_end; offset += ARCHIVE_HAND_HEAD + hand->size)
+    {
+        if (read_hand(archive, offset, hand) != POKER_OK) return POKER_ERR;
+        if (hand->time >= time) return POKER_OK;
+    }
+    return POKER_NONE;
+}
+
+/* POKER_Next_Hand: scan the hands of an archive in order,
+   * parameter: ARCHIVE_TP archive -- the pointer to the archive
+                int table -- the table of hands, -1 for all tables
+                HAND_T *hand -- the hand before, its data NULL to start from the first hand,
+                                the next hand when found
+   * return value: POKER_OK for found, POKER_NONE for no more hand, POKER_ERR for fail
+   * comment: index entries without table are skipped */
+int POKER_Next_Hand(ARCHIVE_TP archive, int table, HAND_T *hand)
+{
+    const unsigned char *entry = NULL;
+    uint64_t            offset = ARCHIVE_HEAD_SIZE;
+    unsigned int        idx = 0;
+
+    if ((archive == NULL) || (hand == NULL)) return POKER_ERR;
+    if (hand->data != NULL)
+    {
+        if (((const unsigned char *)hand->data < archive->map + ARCHIVE_HEAD_SIZE + ARCHIVE_HAND_HEAD) ||
+            ((const unsigned char *)hand->data > archive->map + archive->hand_end)) return POKER_ERR;
+        offset = (const unsigned char *)hand->data - archive->map + hand->size;
+    }
+    if ((table >= 0) && ((idx = find_entry(archive, 16, offset)) > 0)) idx--;
+
+    while (offset < archive->hand_end)
+    {
+        if (table >= 0)
+        {
+            while (offset >= entry_offset(archive, idx + 1)) idx++;
+            entry = archive->index + (size_t)idx * ARCHIVE_ENTRY_SIZE;
+            if ((idx < archive->entry_num) &&
+                (((unsigned int)table < get_32(entry + 24)) || ((unsigned int)table > get_32(entry + 28))))
+            {
+                offset = entry_offset(archive, idx + 1);
+                continue;
+            }
+        }
+        if (read_hand(archive, offset, hand) != POKER_OK) return POKER_ERR;
+        if ((table < 0) || (hand->table == table)) return POKER_OK;
+        offset += ARCHIVE_HAND_HEAD + hand->size;
+    }
+    return POKER_NONE;
+}
@@ -0,0 +1,355 @@
+/* micro benchmark of poker_lib
+   * every case runs on a pile of 5 ~ 416 cards of a list and an array deck,
+     one csv line a case: op,deck,size,iterations,ns_per_op,allocs_per_op,bytes_per_op
+   * allocations are counted by linking with -Wl,--wrap=malloc,--wrap=calloc,--wrap=realloc,--wrap=free
+   * usage: poker_bench [ms of every case] */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "poker.h"
+
+#define BENCH_MS        10     /* default time of every case */
+#define BENCH_PLAYERS   2      /* player 1 is tested, player 2 keeps the other cards */
+#define BENCH_KEEP      2
+#define BENCH_MAX_SIZE  416    /* the biggest pile of sizes */
+
+typedef struct bench_s
+{
+    DECK_TP     deck;
+    int         size;       /* card number of the pile under test */
+    int         pile_no;
+    int         flag;
+    int         (*comp_func)(int card1, int card2);
+    long        count;      /* ops done, for the index of show */
+} BENCH_T;
+
+typedef struct case_s
+{
+    const char  *name;
+    int         pile_no;
+    int         (*comp_func)(int card1, int card2);
+    int         (*op)(BENCH_T *bench);
+    int         (*undo)(BENCH_T *bench);    /* put the pile back after op, its time is not counted, NULL for none */
+} CASE_T;
+
+static long alloc_num = 0;
+static long alloc_bytes = 0;
+static long long clock_ns = 0;
+
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t num, size_t size);
+void *__real_realloc(void *ptr, size_t size);
+void __real_free(void *ptr);
+
+void *__wrap_malloc(size_t size)
+{
+    alloc_num++;
+    alloc_bytes += size;
+    return __real_malloc(size);
+}
+
+void *__wrap_calloc(size_t num, size_t size)
+{
+    alloc_num++;
+    alloc_bytes += num * size;
+    return __real_calloc(num, size);
+}
+
+void *__wrap_realloc(void *ptr, size_t size)
+{
+    alloc_num++;
+    alloc_bytes += size;
+    return __real_realloc(ptr, size);
+}
+
+void __wrap_free(void *ptr)
+{
+    __real_free(ptr);
+}
+
+static long long now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+/* a compare rule the library does not know, sorted by comparisons */
+static int comp_user(int card1, int card2)
+{
+    return POKER_Comp_ColorNum(card1, card2);
+}
+
+/* never found, every card is visited */
+static int search_none(int index, int card, void *para)
+{
+    (*(long *)para)++;
+    return POKER_NONE;
+}
+
+static int op_create(BENCH_T *bench)
+{
+    DECK_TP deck = POKER_Create_DeckEx(BENCH_PLAYERS, 0, bench->flag);
+
+    if (deck == NULL) return POKER_ERR;
+    POKER_Delete_Deck(&deck);
+    return POKER_OK;
+}
+
+static int op_shuffle(BENCH_T *bench)
+{
+    if (bench->pile_no == POKER_PILE_LAST) return POKER_Shuffle_LastPile(bench->deck);
+    if (bench->pile_no == POKER_PILE_TRASH) return POKER_Shuffle_TrashPile(bench->deck);
+    return POKER_Shuffle_PlayerPile(bench->deck, bench->pile_no);
+}
+
+/* POKER_Shuffle_TrashPile puts trash pile behind last pile */
+static int undo_shuffle_trash(BENCH_T *bench)
+{
+    return POKER_Move_Pile(bench->deck, POKER_PILE_LAST, POKER_PILE_TRASH, POKER_FROM_TOP);
+}
+
+static int op_deal_top(BENCH_T *bench)
+{
+    return POKER_Deal_Card(bench->deck, POKER_FROM_TOP, 0, 1);
+}
+
+static int op_deal_bottom(BENCH_T *bench)
+{
+    return POKER_Deal_Card(bench->deck, POKER_FROM_BOTTOM, 0, 1);
+}
+
+static int op_deal_index(BENCH_T *bench)
+{
+    return POKER_Deal_Card(bench->deck, POKER_FROM_INDEX, bench->size / 2, 1);
+}
+
+static int undo_deal_top(BENCH_T *bench)
+{
+    return POKER_Move_PileRange(bench->deck, 1, 0, 1, POKER_PILE_LAST, POKER_FROM_TOP);
+}
+
+static int undo_deal_bottom(BENCH_T *bench)
+{
+    return POKER_Move_PileRange(bench->deck, 1, 0, 1, POKER_PILE_LAST, POKER_FROM_BOTTOM);
+}
+
+/* every index of pile in turn */
+static int op_show(BENCH_T *bench)
+{
+    int index = (int)(bench->count++ % bench->size);
+    int card = 0;
+
+    if (bench->pile_no == POKER_PILE_LAST) card = POKER_Show_LastCard(bench->deck, POKER_FROM_INDEX, index);
+    else if (bench->pile_no == POKER_PILE_TRASH) card = POKER_Show_TrashCard(bench->deck, POKER_FROM_INDEX, index);
+    else card = POKER_Show_PlayerCard(bench->deck, bench->pile_no, POKER_FROM_INDEX, index);
+    return (card == POKER_ERR) ? POKER_ERR : POKER_OK;
+}
+
+static int op_sort(BENCH_T *bench)
+{
+    if (bench->pile_no == POKER_PILE_LAST) return POKER_Sort_LastPile(bench->deck, bench->comp_func);
+    if (bench->pile_no == POKER_PILE_TRASH) return POKER_Sort_TrashPile(bench->deck, bench->comp_func);
+    return POKER_Sort_PlayerPile(bench->deck, bench->pile_no, bench->comp_func);
+}
+
+/* a sorted pile is shuffled again, trash pile is shuffled in place of it */
+static int undo_sort(BENCH_T *bench)
+{
+    if (bench->pile_no != POKER_PILE_TRASH) return op_shuffle(bench);
+    if (POKER_Shuffle_TrashPile(bench->deck) != POKER_OK) return POKER_ERR;
+    return undo_shuffle_trash(bench);
+}
+
+static int op_search(BENCH_T *bench)
+{
+    int rv = POKER_ERR;
+
+    if (bench->pile_no == POKER_PILE_LAST) rv = POKER_Search_LastPile(bench->deck, search_none, &bench->count);
+    else if (bench->pile_no == POKER_PILE_TRASH) rv = POKER_Search_TrashPile(bench->deck, search_none, &bench->count);
+    else rv = POKER_Search_PlayerPile(bench->deck, bench->pile_no, search_none, &bench->count);
+    return (rv == POKER_NONE) ? POKER_OK : POKER_ERR;
+}
+
+/* every card is visited inline */
+static int op_cursor(BENCH_T *bench)
+{
+    CURSOR_T cursor;
+    int card = 0;
+
+    for (card = POKER_Begin_Cursor(bench->deck, bench->pile_no, &cursor); card >= 0; card = POKER_Next_Cursor(&cursor))
+        bench->count++;
+    POKER_End_Cursor(&cursor);
+    return (card == POKER_NONE) ? POKER_OK : POKER_ERR;
+}
+
+static int op_copy(BENCH_T *bench)
+{
+    static int cards[BENCH_MAX_SIZE];
+
+    return (POKER_Get_PileCards(bench->deck, bench->pile_no, cards, BENCH_MAX_SIZE) == bench->size) ? POKER_OK : POKER_ERR;
+}
+
+#define SORT_CASES(name, pile_no) \
+    { "sort_" name "_color_num", pile_no, POKER_Comp_ColorNum, op_sort, undo_sort }, \
+    { "sort_" name "_color_num_ace_high", pile_no, POKER_Comp_ColorNumAceHigh, op_sort, undo_sort }, \
+    { "sort_" name "_num_color", pile_no, POKER_Comp_NumColor, op_sort, undo_sort }, \
+    { "sort_" name "_num_color_ace_high", pile_no, POKER_Comp_NumColorAceHigh, op_sort, undo_sort }, \
+    { "sort_" name "_user", pile_no, comp_user, op_sort, undo_sort }
+
+static const CASE_T cases[] =
+{
+    { "create_delete", POKER_PILE_LAST, NULL, op_create, NULL },
+    { "shuffle_last", POKER_PILE_LAST, NULL, op_shuffle, NULL },
+    { "shuffle_trash", POKER_PILE_TRASH, NULL, op_shuffle, undo_shuffle_trash },
+    { "shuffle_player", 1, NULL, op_shuffle, NULL },
+    { "deal_top", POKER_PILE_LAST, NULL, op_deal_top, undo_deal_top },
+    { "deal_bottom", POKER_PILE_LAST, NULL, op_deal_bottom, undo_deal_bottom },
+    { "deal_index", POKER_PILE_LAST, NULL, op_deal_index, undo_deal_top },
+    { "show_last", POKER_PILE_LAST, NULL, op_show, NULL },
+    { "show_trash", POKER_PILE_TRASH, NULL, op_show, NULL },
+    { "show_player", 1, NULL, op_show, NULL },
+    SORT_CASES("last", POKER_PILE_LAST),
+    SORT_CASES("trash", POKER_PILE_TRASH),
+    SORT_CASES("player", 1),
+    { "search_last", POKER_PILE_LAST, NULL, op_search, NULL },
+    { "search_trash", POKER_PILE_TRASH, NULL, op_search, NULL },
+    { "search_player", 1, NULL, op_search, NULL },
+    { "cursor_last", POKER_PILE_LAST, NULL, op_cursor, NULL },
+    { "cursor_trash", POKER_PILE_TRASH, NULL, op_cursor, NULL },
+    { "cursor_player", 1, NULL, op_cursor, NULL },
+    { "copy_last", POKER_PILE_LAST, NULL, op_copy, NULL },
+    { "copy_trash", POKER_PILE_TRASH, NULL, op_copy, NULL },
+    { "copy_player", 1, NULL, op_copy, NULL },
+};
+
+static const int sizes[] = { 5, 13, 52, 104, 208, 416 };
+
+/* a deck of packs enough for size, only the pile under test and player 2 have cards */
+static int setup_deck(BENCH_T *bench)
+{
+    if ((bench->deck = POKER_Create_DeckEx(BENCH_PLAYERS, 0, bench->flag)) == NULL) return POKER_ERR;
+    if ((POKER_Seed_Deck(bench->deck, 1) != POKER_OK) ||
+        (POKER_Move_Pile(bench->deck, POKER_PILE_LAST, BENCH_KEEP, POKER_FROM_TOP) != POKER_OK) ||
+        (POKER_Move_PileRange(bench->deck, BENCH_KEEP, 0, bench->size, bench->pile_no, POKER_FROM_TOP) != POKER_OK) ||
+        (undo_sort(bench) != POKER_OK))
+    {
+        POKER_Delete_Deck(&bench->deck);
+        return POKER_ERR;
+    }
+    return POKER_OK;
+}
+
+/* time of iters ops, an op with undo is timed alone and the time of clock is taken off,
+   wall is the time of loop */
+static long long run_loop(BENCH_T *bench, const CASE_T *c, long iters, long long *wall)
+{
+    long long start = now_ns();
+    long long total = 0;
+    long long begin = 0;
+    long idx = 0;
+
+    for (idx = 0; idx < iters; idx++)
+    {
+        if (c->undo == NULL)
+        {
+            if (c->op(bench) != POKER_OK) return -1;
+            continue;
+        }
+        begin = now_ns();
+        if (c->op(bench) != POKER_OK) return -1;
+        total += now_ns() - begin - clock_ns;
+        if (c->undo(bench) != POKER_OK) return -1;
+    }
+    *wall = now_ns() - start;
+    if (c->undo == NULL) total = *wall;
+    return (total < 0) ? 0 : total;
+}
+
+static int run_case(const CASE_T *c, int flag, int size, long long case_ns)
+{
+    BENCH_T bench;
+    long iters = 1;
+    long long total = 0;
+    long long wall = 0;
+    long allocs = 0;
+    long bytes = 0;
+
+    memset(&bench, 0, sizeof(bench));
+    bench.size = size;
+    bench.pile_no = c->pile_no;
+    bench.flag = flag | POKER_DECK_PACK((size + POKER_CARD_NUM - 1) / POKER_CARD_NUM);
+    bench.comp_func = c->comp_func;
+    if (setup_deck(&bench) != POKER_OK) return POKER_ERR;
+
+    /* double iterations until a loop takes the time of case */
+    while (((total = run_loop(&bench, c, iters, &wall)) >= 0) && (wall < case_ns / 2)) iters *= 2;
+    if (total >= 0)
+    {
+        allocs = alloc_num;
+        bytes = alloc_bytes;
+        total = run_loop(&bench, c, iters, &wall);
+        allocs = alloc_num - allocs;
+        bytes = alloc_bytes - bytes;
+    }
+    POKER_Delete_Deck(&bench.deck);
+    if (total < 0) return POKER_ERR;
+
+    printf("%s,%s,%d,%ld,%.2f,%.2f,%.2f\n", c->name, (flag == POKER_DECK_ARRAY) ? "array" : "list", size, iters,
+           (double)total / iters, (double)allocs / iters, (double)bytes / iters);
+    fflush(stdout);
+    return POKER_OK;
+}
+
+/* the time of a now_ns call, the least of many */
+static long long calibrate_clock(void)
+{
+    long long least = 0;
+    long long begin = 0;
+    long long diff = 0;
+    int idx = 0;
+
+    for (idx = 0; idx < 100000; idx++)
+    {
+        begin = now_ns();
+        diff = now_ns() - begin;
+        if ((idx == 0) || (diff < least)) least = diff;
+    }
+    return least;
+}
+
+int main(int argc, char **argv)
+{
+    static const int flags[] = { POKER_DECK_LIST, POKER_DECK_ARRAY };
+    long long case_ns = (long long)BENCH_MS * 1000000LL;
+    int flag = 0;
+    int size = 0;
+    int idx = 0;
+    int err = 0;
+
+    if (argc > 1) case_ns = atoll(argv[1]) * 1000000LL;
+    if (case_ns <= 0)
+    {
+        fprintf(stderr, "usage: %s [ms of every case]\n", argv[0]);
+        return 1;
+    }
+
+    clock_ns = calibrate_clock();
+    printf("op,deck,size,iterations,ns_per_op,allocs_per_op,bytes_per_op\n");
+    for (flag = 0; flag < (int)(sizeof(flags) / sizeof(flags[0])); flag++)
+    {
+        for (size = 0; size < (int)(sizeof(sizes) / sizeof(sizes[0])); size++)
+        {
+            for (idx = 0; idx < (int)(sizeof(cases) / sizeof(cases[0])); idx++)
+            {
+                if (run_case(&cases[idx], flags[flag], sizes[size], case_ns) == POKER_OK) continue;
+                fprintf(stderr, "%s,%d,%d: failed\n", cases[idx].name, flags[flag], sizes[size]);
+                err = 1;
+            }
+        }
+    }
+    return err;
+}
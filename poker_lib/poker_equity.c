@@ -0,0 +1,759 @@
+/* Texas Hold'em equity calculator
+   * boards are dealt from the cards of last_pile, exhaustively or by Monte Carlo sampling,
+     and every board is evaluated with the incremental hand of poker_table.h,
+     the hole cards of every player are added to the board once */
+#include <pthread.h>
+#include <unistd.h>
+
+#include "poker.h"
+#include "poker_table.h"
+
+#define EQUITY_BOARD    5
+#define EQUITY_BATCH    4096    /* Monte Carlo boards between checks of standard error */
+#define EQUITY_THREAD   64
+#define EQUITY_TRIALS   0x70000000  /* most trials, boards started may pass it by a batch of every thread */
+#define EQUITY_SPLIT    2520        /* units of a pot, split evenly by 1 ~ 10 winners */
+
+typedef struct equity_job_s
+{
+    int                 player_num;
+    EVAL_HAND_T         hole[POKER_EQUITY_PLAYER];    /* hole cards and known board of every player */
+    int                 card[POKER_CARD_NUM];         /* cards to deal, as poker_card_bit */
+    int                 card_num;
+    int                 need;                         /* board cards to deal */
+    int                 trials;                       /* 0 for all boards */
+    double              std_err;
+    int                 next;                         /* next first card, or boards started of Monte Carlo */
+    int                 done;
+    pthread_mutex_t     lock;
+    unsigned long long  total;
+    unsigned long long  win[POKER_EQUITY_PLAYER];
+    unsigned long long  tie[POKER_EQUITY_PLAYER];
+    double              share[POKER_EQUITY_PLAYER];   /* sum of pot share */
+    double              square[POKER_EQUITY_PLAYER];  /* sum of squared pot share, for standard error */
+} EQUITY_JOB_T;
+
+typedef struct equity_worker_s
+{
+    EQUITY_JOB_T        *job;
+    unsigned long long  seed;
+    DECK_TP             rand_deck;                    /* random numbers of Monte Carlo */
+    pthread_t           thread;
+    unsigned long long  total;
+    unsigned long long  win[POKER_EQUITY_PLAYER];
+    unsigned long long  tie[POKER_EQUITY_PLAYER];
+    unsigned long long  share[POKER_EQUITY_PLAYER];   /* sum of pot share in EQUITY_SPLIT units */
+    unsigned long long  square[POKER_EQUITY_PLAYER];  /* sum of squared pot share in units */
+} EQUITY_WORKER_T;
+
+/* count a board won by winners players, a pot is split in EQUITY_SPLIT units */
+static inline void count_win(EQUITY_WORKER_T *worker, int idx, int winners, unsigned long long num)
+{
+    unsigned long long split = EQUITY_SPLIT / winners;
+
+    if (winners == 1) worker->win[idx] += num;
+    else worker->tie[idx] += num;
+    worker->share[idx] += split * num;
+    worker->square[idx] += split * split * num;
+}
+
+/* evaluate the hands of all players on a board */
+static void showdown(EQUITY_WORKER_T *worker, const EVAL_HAND_T *board)
+{
+    EQUITY_JOB_T *job = worker->job;
+    EVAL_HAND_T hand;
+    int value[POKER_EQUITY_PLAYER];
+    int best = 0;
+    int winners = 0;
+    int idx = 0;
+
+    for (idx = 0; idx < job->player_num; idx++)
+    {
+        eval_join(&hand, &job->hole[idx], board);
+        value[idx] = eval_value(&hand);
+        if (value[idx] > best)
+        {
+            best = value[idx];
+            winners = 1;
+        }
+        else if (value[idx] == best) winners++;
+    }
+
+    worker->total++;
+    for (idx = 0; idx < job->player_num; idx++)
+    {
+        if (value[idx] == best) count_win(worker, idx, winners, 1);
+    }
+}
+
+/* deal the last card of heads-up boards from card[start] on, counts are kept in registers */
+static void deal_heads_up(EQUITY_WORKER_T *worker, const EVAL_HAND_T *board, int start)
+{
+    EQUITY_JOB_T *job = worker->job;
+    EVAL_HAND_T hand0;
+    EVAL_HAND_T hand1;
+    EVAL_HAND_T next;
+    unsigned long long win0 = 0;
+    unsigned long long win1 = 0;
+    unsigned long long tie = 0;
+    int value0 = 0;
+    int value1 = 0;
+    int key = 0;
+    int idx = 0;
+
+    eval_join(&hand0, &job->hole[0], board);
+    eval_join(&hand1, &job->hole[1], board);
+
+    /* no color of 4 cards in either hand, the last card makes no flush and only the keys count */
+    if (!(((hand0.colors | hand1.colors) + 0x4444) & 0x8888))
+    {
+        for (idx = start; idx < job->card_num; idx++)
+        {
+            key = poker_num_key[job->card[idx] & 0x0F];
+            value0 = eval_key_value(hand0.key + key);
+            value1 = eval_key_value(hand1.key + key);
+            win0 += (value0 > value1);
+            win1 += (value0 < value1);
+            tie += (value0 == value1);
+        }
+        start = job->card_num;
+    }
+    for (idx = start; idx < job->card_num; idx++)
+    {
+        next = hand0;
+        eval_add(&next, job->card[idx]);
+        value0 = eval_value(&next);
+        next = hand1;
+        eval_add(&next, job->card[idx]);
+        value1 = eval_value(&next);
+        win0 += (value0 > value1);
+        win1 += (value0 < value1);
+        tie += (value0 == value1);
+    }
+    worker->total += win0 + win1 + tie;
+    count_win(worker, 0, 1, win0);
+    count_win(worker, 1, 1, win1);
+    count_win(worker, 0, 2, tie);
+    count_win(worker, 1, 2, tie);
+}
+
+/* deal left cards from card[start] on, every combination once */
+static void deal_boards(EQUITY_WORKER_T *worker, const EVAL_HAND_T *board, int start, int left)
+{
+    EQUITY_JOB_T *job = worker->job;
+    EVAL_HAND_T next;
+    int idx = 0;
+
+    if (left == 0)
+    {
+        showdown(worker, board);
+        return;
+    }
+    if ((left == 1) && (job->player_num == 2))
+    {
+        deal_heads_up(worker, board, start);
+        return;
+    }
+    for (idx = start; idx <= job->card_num - left; idx++)
+    {
+        next = *board;
+        eval_add(&next, job->card[idx]);
+        deal_boards(worker, &next, idx + 1, left - 1);
+    }
+}
+
+/* merge the counts of a worker into job, check if Monte Carlo is done */
+static void merge_worker(EQUITY_WORKER_T *worker)
+{
+    EQUITY_JOB_T *job = worker->job;
+    double mean = 0.0;
+    int idx = 0;
+    int done = 1;
+
+    pthread_mutex_lock(&job->lock);
+    job->total += worker->total;
+    for (idx = 0; idx < job->player_num; idx++)
+    {
+        job->win[idx] += worker->win[idx];
+        job->tie[idx] += worker->tie[idx];
+        job->share[idx] += (double)worker->share[idx] / EQUITY_SPLIT;
+        job->square[idx] += (double)worker->square[idx] / ((double)EQUITY_SPLIT * EQUITY_SPLIT);
+        worker->win[idx] = worker->tie[idx] = 0;
+        worker->share[idx] = worker->square[idx] = 0;
+        if ((job->trials == 0) || (job->std_err == 0.0) || (job->total == 0)) continue;
+
+        /* variance of mean share is (E[x^2] - E[x]^2) / n */
+        mean = job->share[idx] / job->total;
+        if ((job->square[idx] / job->total - mean * mean) / job->total > job->std_err * job->std_err) done = 0;
+    }
+    worker->total = 0;
+    if ((job->trials > 0) && (job->std_err > 0.0) && done) __sync_fetch_and_or(&job->done, 1);
+    pthread_mutex_unlock(&job->lock);
+}
+
+/* deal the boards of a job, with other workers of the job */
+static void run_job(EQUITY_WORKER_T *worker)
+{
+    EQUITY_JOB_T *job = worker->job;
+    EVAL_HAND_T board;
+    int card[POKER_CARD_NUM];
+    int first = 0;
+    int num = 0;
+    int idx = 0;
+    int pick = 0;
+    int bit = 0;
+
+    memset(&board, 0, sizeof(board));
+    if (job->trials == 0)
+    {
+        /* all boards, a task is the boards from a first card */
+        while ((first = __sync_fetch_and_add(&job->next, 1)) <= job->card_num - job->need)
+        {
+            if (job->need == 0)
+            {
+                if (first == 0) showdown(worker, &board);
+                continue;
+            }
+            board.bits = 0;
+            board.colors = 0;
+            board.key = 0;
+            eval_add(&board, job->card[first]);
+            deal_boards(worker, &board, first + 1, job->need - 1);
+        }
+        merge_worker(worker);
+        return;
+    }
+
+    memcpy(card, job->card, job->card_num * sizeof(int));
+    while (!__sync_fetch_and_add(&job->done, 0))
+    {
+        num = __sync_fetch_and_add(&job->next, EQUITY_BATCH);
+        if (num >= job->trials) break;
+        if (num + EQUITY_BATCH > job->trials) num = job->trials - num;
+        else num = EQUITY_BATCH;
+
+        while (num-- > 0)
+        {
+            /* partial Fisher-Yates shuffle of the cards to deal */
+            memset(&board, 0, sizeof(board));
+            for (idx = 0; idx < job->need; idx++)
+            {
+                pick = idx + POKER_Rand_Deck(worker->rand_deck, job->card_num - idx);
+                bit = card[pick];
+                card[pick] = card[idx];
+                card[idx] = bit;
+                eval_add(&board, bit);
+            }
+            showdown(worker, &board);
+        }
+        merge_worker(worker);
+    }
+}
+
+static void *run_worker(void *para)
+{
+    EQUITY_WORKER_T *worker = (EQUITY_WORKER_T *)para;
+    void *mem[256];
+
+    /* random numbers from a deck of no player in stack */
+    worker->rand_deck = POKER_Init_Deck(mem, sizeof(mem), 0, 0, POKER_DECK_ARRAY, worker->seed);
+    if (worker->rand_deck == NULL) return NULL;
+    run_job(worker);
+    return NULL;
+}
+
+/* cards of last_pile to deal as poker_card_bit, jokers, dead cards and copies of a shoe are skipped,
+   return the number of cards */
+static int list_cards(DECK_TP deck, unsigned long long *dead, int *card)
+{
+    int card_num = POKER_Get_LastCardNum(deck);
+    int num = 0;
+    int bit = 0;
+    int idx = 0;
+
+    for (idx = 0; idx < card_num; idx++)
+    {
+        bit = POKER_Show_LastCard(deck, POKER_FROM_INDEX, idx);
+        if (bit == POKER_ERR) continue;
+        bit = poker_card_bit[bit & 0xFF];
+        if ((bit < 0) || (*dead & (1ULL << bit))) continue;
+        *dead |= 1ULL << bit;
+        card[num++] = bit;
+    }
+    return num;
+}
+
+static int thread_num(int threads)
+{
+    if (threads == 0) threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    if (threads < 1) threads = 1;
+    if (threads > EQUITY_THREAD) threads = EQUITY_THREAD;
+    return threads;
+}
+
+/* a seed of a worker, deck has a copy of the random number generator of caller */
+static unsigned long long rand_seed(DECK_TP deck)
+{
+    return ((unsigned long long)POKER_Rand_Deck(deck, 0x7FFFFFFF) << 31) ^
+           (unsigned long long)POKER_Rand_Deck(deck, 0x7FFFFFFF);
+}
+
+/* POKER_Calc_Equity: calculate the equity of Texas Hold'em players by dealing the board,
+   * parameter: DECK_TP deck -- the pointer to a deck of poker, 2 ~ 10 players with 2 hole cards each,
+                                the board is dealt from last_pile
+                const int *board -- the community cards known, NULL for none
+                int board_num -- the number of community cards known, 0 ~ 5
+                int trials -- 0 for all boards, or the most boards of Monte Carlo sampling
+                double std_err -- Monte Carlo stops when the standard error of every equity is
+                                  under it, 0 for all trials
+                int threads -- the number of threads, 0 for all cores
+                EQUITY_T *equity -- the result
+   * return value: POKER_OK for success, POKER_ERR for fail
+   * comment: cards not in last_pile are dead, the deck is not changed, a copy of its random number
+              generator seeds Monte Carlo, there is no memory allocation */
+int POKER_Calc_Equity(DECK_TP deck, const int *board, int board_num, int trials, double std_err,
+                      int threads, EQUITY_T *equity)
+{
+    EQUITY_JOB_T job;
+    EQUITY_WORKER_T worker[EQUITY_THREAD];
+    EVAL_HAND_T known;
+    DECK_TP rand_deck = NULL;
+    void *mem[256];
+    unsigned long long dead = 0;
+    int player_num = 0;
+    int bit = 0;
+    int idx = 0;
+    int num = 0;
+
+    if ((deck == NULL) || (equity == NULL)) return POKER_ERR;
+    if ((board_num < 0) || (board_num > EQUITY_BOARD)) return POKER_ERR;
+    if ((board == NULL) && (board_num > 0)) return POKER_ERR;
+    if ((trials < 0) || (trials > EQUITY_TRIALS) || (std_err < 0.0)) return POKER_ERR;
+    while (POKER_Get_PlayerCardNum(deck, player_num + 1) >= 0) player_num++;
+    if ((player_num < 2) || (player_num > POKER_EQUITY_PLAYER)) return POKER_ERR;
+
+    memset(&job, 0, sizeof(job));
+    memset(&known, 0, sizeof(known));
+    job.player_num = player_num;
+    job.need = EQUITY_BOARD - board_num;
+    job.trials = trials;
+    job.std_err = std_err;
+    for (idx = 0; idx < board_num; idx++)
+    {
+        bit = poker_card_bit[board[idx] & 0xFF];
+        if ((bit < 0) || (dead & (1ULL << bit))) return POKER_ERR;
+        dead |= 1ULL << bit;
+        eval_add(&known, bit);
+    }
+    for (idx = 0; idx < player_num; idx++)
+    {
+        if (POKER_Get_PlayerCardNum(deck, idx + 1) != 2) return POKER_ERR;
+        job.hole[idx] = known;
+        for (num = 0; num < 2; num++)
+        {
+            bit = poker_card_bit[POKER_Show_PlayerCard(deck, idx + 1, POKER_FROM_INDEX, num) & 0xFF];
+            if ((bit < 0) || (dead & (1ULL << bit))) return POKER_ERR;
+            dead |= 1ULL << bit;
+            eval_add(&job.hole[idx], bit);
+        }
+    }
+
+    job.card_num = list_cards(deck, &dead, job.card);
+    if (job.card_num < job.need) return POKER_ERR;
+
+    threads = thread_num(threads);
+    /* a turn or river is too small to share */
+    if ((trials == 0) && (job.need < 3)) threads = 1;
+    if ((trials > 0) && (trials <= EQUITY_BATCH)) threads = 1;
+
+    /* seeds of workers come from a copy of the random number generator, the deck is not changed */
+    if ((rand_deck = POKER_Init_Deck(mem, sizeof(mem), 0, 0, POKER_DECK_ARRAY, 0)) == NULL) return POKER_ERR;
+    POKER_Copy_DeckRandom(rand_deck, deck);
+    pthread_mutex_init(&job.lock, NULL);
+    memset(worker, 0, threads * sizeof(EQUITY_WORKER_T));
+    for (idx = 0; idx < threads; idx++)
+    {
+        worker[idx].job = &job;
+        worker[idx].seed = rand_seed(rand_deck);
+    }
+    /* the calling thread is worker 0, workers not created leave their work to others */
+    for (num = 1; num < threads; num++)
+    {
+        if (pthread_create(&worker[num].thread, NULL, run_worker, &worker[num]) != 0) break;
+    }
+    run_worker(&worker[0]);
+    for (idx = 1; idx < num; idx++) pthread_join(worker[idx].thread, NULL);
+    pthread_mutex_destroy(&job.lock);
+
+    memset(equity, 0, sizeof(EQUITY_T));
+    equity->player_num = player_num;
+    equity->total = job.total;
+    for (idx = 0; idx < player_num; idx++)
+    {
+        equity->win[idx] = job.win[idx];
+        equity->tie[idx] = job.tie[idx];
+        if (job.total > 0) equity->equity[idx] = job.share[idx] / job.total;
+    }
+    return POKER_OK;
+}
+
+/* matchups of ranges, a matchup is the hole cards of every seat */
+typedef struct range_job_s
+{
+    int                 seat_num;
+    int                 need;
+    int                 trials;
+    EVAL_HAND_T         known;                        /* known board */
+    int                 card[POKER_CARD_NUM];         /* cards to deal, as poker_card_bit */
+    int                 card_num;
+    int                 *combo;                       /* 2 card bits of every combination of every seat */
+    double              *combo_weight;
+    int                 combo_num[POKER_EQUITY_PLAYER];
+    int                 perm_num;
+    int                 perm[24][4];                  /* exchanges of colors keeping board and dead cards */
+    unsigned long long  total;                        /* matchups of ranges */
+    int                 matchup_num;                  /* different matchups */
+    int                 matchup_max;
+    unsigned short      *key;                         /* 2 card bits of every seat of a matchup */
+    double              *weight;                      /* weight of a matchup */
+    double              *equity;                      /* equity of every seat of a matchup */
+    int                 slot_num;                     /* hash of matchups, power of 2 */
+    int                 *slot;                        /* matchup + 1 of a key, 0 for empty */
+    int                 next;                         /* next matchup to calculate */
+} RANGE_JOB_T;
+
+typedef struct range_worker_s
+{
+    RANGE_JOB_T         *range;
+    unsigned long long  seed;
+    pthread_t           thread;
+} RANGE_WORKER_T;
+
+static unsigned int hash_key(const unsigned short *key, int num)
+{
+    unsigned int hash = 2166136261U;
+    int idx = 0;
+
+    for (idx = 0; idx < num; idx++) hash = (hash ^ key[idx]) * 16777619U;
+    return hash;
+}
+
+/* cards of a color exchanged as perm */
+static unsigned long long perm_bits(unsigned long long bits, const int *perm)
+{
+    unsigned long long result = 0;
+    int color = 0;
+
+    for (color = 0; color < 4; color++) result |= ((bits >> (color * 16)) & 0xFFFF) << (perm[color] * 16);
+    return result;
+}
+
+/* key of 2 card bits, the higher first */
+static unsigned short hole_key(int bit1, int bit2)
+{
+    return (bit1 > bit2) ? ((bit1 << 6) | bit2) : ((bit2 << 6) | bit1);
+}
+
+/* list the exchanges of colors which keep the cards to deal and board */
+static void list_perms(RANGE_JOB_T *range, unsigned long long live, unsigned long long board)
+{
+    int perm[4];
+    int idx = 0;
+
+    for (perm[0] = 0; perm[0] < 4; perm[0]++)
+    for (perm[1] = 0; perm[1] < 4; perm[1]++)
+    for (perm[2] = 0; perm[2] < 4; perm[2]++)
+    for (perm[3] = 0; perm[3] < 4; perm[3]++)
+    {
+        if ((perm[0] == perm[1]) || (perm[0] == perm[2]) || (perm[0] == perm[3]) ||
+            (perm[1] == perm[2]) || (perm[1] == perm[3]) || (perm[2] == perm[3])) continue;
+        if ((perm_bits(live, perm) != live) || (perm_bits(board, perm) != board)) continue;
+        for (idx = 0; idx < 4; idx++) range->perm[range->perm_num][idx] = perm[idx];
+        range->perm_num++;
+    }
+}
+
+/* double the matchups and hash of a range job */
+static int grow_matchups(RANGE_JOB_T *range)
+{
+    unsigned short *key = NULL;
+    double *weight = NULL;
+    int *slot = NULL;
+    int max = range->matchup_max ? range->matchup_max * 2 : 1024;
+    int idx = 0;
+    int pos = 0;
+
+    key = (unsigned short *)realloc(range->key, (size_t)max * range->seat_num * sizeof(unsigned short));
+    if (key == NULL) return POKER_ERR;
+    range->key = key;
+    weight = (double *)realloc(range->weight, (size_t)max * sizeof(double));
+    if (weight == NULL) return POKER_ERR;
+    range->weight = weight;
+    slot = (int *)calloc((size_t)max * 2, sizeof(int));
+    if (slot == NULL) return POKER_ERR;
+
+    for (idx = 0; idx < range->matchup_num; idx++)
+    {
+        pos = hash_key(range->key + idx * range->seat_num, range->seat_num) & (max * 2 - 1);
+        while (slot[pos]) pos = (pos + 1) & (max * 2 - 1);
+        slot[pos] = idx + 1;
+    }
+    free(range->slot);
+    range->slot = slot;
+    range->slot_num = max * 2;
+    range->matchup_max = max;
+    return POKER_OK;
+}
+
+/* add the weight of a matchup to the matchup same with it after exchanging colors */
+static int add_matchup(RANGE_JOB_T *range, const unsigned short *hole, double weight)
+{
+    unsigned short best[POKER_EQUITY_PLAYER];
+    unsigned short key[POKER_EQUITY_PLAYER];
+    const int *perm = NULL;
+    int seat = 0;
+    int idx = 0;
+    int pos = 0;
+
+    /* the smallest key of all exchanges of colors */
+    memcpy(best, hole, range->seat_num * sizeof(unsigned short));
+    for (idx = 0; idx < range->perm_num; idx++)
+    {
+        perm = range->perm[idx];
+        for (seat = 0; seat < range->seat_num; seat++)
+        {
+            key[seat] = hole_key(perm[hole[seat] >> 10] * 16 + ((hole[seat] >> 6) & 0x0F),
+                                 perm[(hole[seat] >> 4) & 0x03] * 16 + (hole[seat] & 0x0F));
+        }
+        for (seat = 0; (seat < range->seat_num) && (key[seat] == best[seat]); seat++);
+        if ((seat < range->seat_num) && (key[seat] < best[seat]))
+            memcpy(best, key, range->seat_num * sizeof(unsigned short));
+    }
+
+    range->total++;
+    pos = hash_key(best, range->seat_num) & (range->slot_num - 1);
+    for (; range->slot[pos]; pos = (pos + 1) & (range->slot_num - 1))
+    {
+        idx = range->slot[pos] - 1;
+        if (memcmp(range->key + idx * range->seat_num, best, range->seat_num * sizeof(unsigned short)) == 0)
+        {
+            range->weight[idx] += weight;
+            return POKER_OK;
+        }
+    }
+
+    idx = range->matchup_num++;
+    memcpy(range->key + idx * range->seat_num, best, range->seat_num * sizeof(unsigned short));
+    range->weight[idx] = weight;
+    range->slot[pos] = idx + 1;
+    if (range->matchup_num == range->matchup_max) return grow_matchups(range);
+    return POKER_OK;
+}
+
+/* every combination of a seat without cards used by seats before */
+static int add_matchups(RANGE_JOB_T *range, int seat, unsigned long long used, unsigned short *hole, double weight)
+{
+    const int *combo = range->combo + seat * POKER_RANGE_COMBO * 2;
+    unsigned long long bits = 0;
+    int idx = 0;
+
+    if (seat == range->seat_num) return add_matchup(range, hole, weight);
+    for (idx = 0; idx < range->combo_num[seat]; idx++, combo += 2)
+    {
+        bits = (1ULL << combo[0]) | (1ULL << combo[1]);
+        if (used & bits) continue;
+        hole[seat] = hole_key(combo[0], combo[1]);
+        if (add_matchups(range, seat + 1, used | bits, hole,
+                         weight * range->combo_weight[seat * POKER_RANGE_COMBO + idx]) != POKER_OK) return POKER_ERR;
+    }
+    return POKER_OK;
+}
+
+/* deal the boards of every different matchup in one thread */
+static void *run_range(void *para)
+{
+    RANGE_WORKER_T *range_worker = (RANGE_WORKER_T *)para;
+    RANGE_JOB_T *range = range_worker->range;
+    EQUITY_JOB_T job;
+    EQUITY_WORKER_T worker;
+    unsigned long long dead = 0;
+    const unsigned short *key = NULL;
+    void *mem[256];
+    int matchup = 0;
+    int seat = 0;
+    int idx = 0;
+
+    memset(&job, 0, sizeof(job));
+    memset(&worker, 0, sizeof(worker));
+    worker.job = &job;
+    worker.rand_deck = POKER_Init_Deck(mem, sizeof(mem), 0, 0, POKER_DECK_ARRAY, range_worker->seed);
+    if (worker.rand_deck == NULL) return NULL;
+    pthread_mutex_init(&job.lock, NULL);
+    job.player_num = range->seat_num;
+    job.need = range->need;
+    job.trials = range->trials;
+
+    while ((matchup = __sync_fetch_and_add(&range->next, 1)) < range->matchup_num)
+    {
+        key = range->key + matchup * range->seat_num;
+        dead = 0;
+        for (seat = 0; seat < range->seat_num; seat++)
+        {
+            job.hole[seat] = range->known;
+            eval_add(&job.hole[seat], key[seat] >> 6);
+            eval_add(&job.hole[seat], key[seat] & 0x3F);
+            dead |= (1ULL << (key[seat] >> 6)) | (1ULL << (key[seat] & 0x3F));
+            job.win[seat] = job.tie[seat] = 0;
+            job.share[seat] = job.square[seat] = 0.0;
+        }
+        job.card_num = 0;
+        for (idx = 0; idx < range->card_num; idx++)
+        {
+            if (!(dead & (1ULL << range->card[idx]))) job.card[job.card_num++] = range->card[idx];
+        }
+        job.total = 0;
+        job.next = 0;
+        job.done = 0;
+
+        run_job(&worker);
+        for (seat = 0; seat < range->seat_num; seat++)
+        {
+            range->equity[matchup * range->seat_num + seat] = job.total ? job.share[seat] / job.total : 0.0;
+        }
+    }
+    pthread_mutex_destroy(&job.lock);
+    return NULL;
+}
+
+/* list the matchups of ranges and calculate them, job has the cards to deal and known board */
+static int calc_range(RANGE_JOB_T *job, DECK_TP deck, const RANGE_T *range, int threads, EQUITY_T *equity)
+{
+    RANGE_WORKER_T worker[EQUITY_THREAD];
+    unsigned short hole[POKER_EQUITY_PLAYER];
+    DECK_TP rand_deck = NULL;
+    void *mem[256];
+    unsigned long long live = 0;
+    double product = 0.0;
+    double sum = 0.0;
+    int bit1 = 0;
+    int bit2 = 0;
+    int seat = 0;
+    int idx = 0;
+    int num = 0;
+
+    for (idx = 0; idx < job->card_num; idx++) live |= 1ULL << job->card[idx];
+    list_perms(job, live, job->known.bits);
+
+    /* combinations of cards to deal only */
+    for (seat = 0; seat < job->seat_num; seat++)
+    {
+        if ((range[seat].combo_num < 0) || (range[seat].combo_num > POKER_RANGE_COMBO)) return POKER_ERR;
+        for (idx = 0; idx < range[seat].combo_num; idx++)
+        {
+            bit1 = poker_card_bit[range[seat].card[idx][0] & 0xFF];
+            bit2 = poker_card_bit[range[seat].card[idx][1] & 0xFF];
+            if ((bit1 < 0) || (bit2 < 0) || (bit1 == bit2)) return POKER_ERR;
+            if (!(live & (1ULL << bit1)) || !(live & (1ULL << bit2)) || (range[seat].weight[idx] <= 0.0)) continue;
+            num = seat * POKER_RANGE_COMBO + job->combo_num[seat]++;
+            job->combo[num * 2] = bit1;
+            job->combo[num * 2 + 1] = bit2;
+            job->combo_weight[num] = range[seat].weight[idx];
+        }
+    }
+    /* matchups listed are at most the product of combinations, it grows as a power of seats */
+    for (seat = 0, product = 1.0; seat < job->seat_num; seat++) product *= job->combo_num[seat];
+    if (product > POKER_RANGE_MATCHUP) return POKER_ERR;
+    if (grow_matchups(job) != POKER_OK) return POKER_ERR;
+    if (add_matchups(job, 0, 0, hole, 1.0) != POKER_OK) return POKER_ERR;
+    if (job->matchup_num == 0) return POKER_ERR;
+    job->equity = (double *)malloc((size_t)job->matchup_num * job->seat_num * sizeof(double));
+    if (job->equity == NULL) return POKER_ERR;
+
+    threads = thread_num(threads);
+    if (threads > job->matchup_num) threads = job->matchup_num;
+    /* seeds of workers come from a copy of the random number generator, the deck is not changed */
+    if ((rand_deck = POKER_Init_Deck(mem, sizeof(mem), 0, 0, POKER_DECK_ARRAY, 0)) == NULL) return POKER_ERR;
+    POKER_Copy_DeckRandom(rand_deck, deck);
+    memset(worker, 0, threads * sizeof(RANGE_WORKER_T));
+    for (idx = 0; idx < threads; idx++)
+    {
+        worker[idx].range = job;
+        worker[idx].seed = rand_seed(rand_deck);
+    }
+    /* the calling thread is worker 0, workers not created leave their work to others */
+    for (num = 1; num < threads; num++)
+    {
+        if (pthread_create(&worker[num].thread, NULL, run_range, &worker[num]) != 0) break;
+    }
+    run_range(&worker[0]);
+    for (idx = 1; idx < num; idx++) pthread_join(worker[idx].thread, NULL);
+
+    memset(equity, 0, sizeof(EQUITY_T));
+    equity->player_num = job->seat_num;
+    equity->total = job->total;
+    for (idx = 0; idx < job->matchup_num; idx++)
+    {
+        sum += job->weight[idx];
+        for (seat = 0; seat < job->seat_num; seat++)
+            equity->equity[seat] += job->weight[idx] * job->equity[idx * job->seat_num + seat];
+    }
+    for (seat = 0; seat < job->seat_num; seat++) equity->equity[seat] /= sum;
+    return POKER_OK;
+}
+
+/* POKER_Calc_RangeEquity: calculate the equity of Texas Hold'em ranges over their matchups,
+   * parameter: DECK_TP deck -- the pointer to a deck of poker, the board is dealt from last_pile
+                const RANGE_T *range -- the range of every seat, from POKER_Parse_Range
+                int range_num -- the number of seats, 2 ~ 10
+                const int *board -- the community cards known, NULL for none
+                int board_num -- the number of community cards known, 0 ~ 5
+                int trials -- 0 for all boards of every matchup, or boards of Monte Carlo sampling
+                              of every matchup
+                int threads -- the number of threads, 0 for all cores
+                EQUITY_T *equity -- the result, total is the number of matchups, equity is weighted
+                                    by the weights of combinations, win and tie are not counted
+   * return value: POKER_OK for success, POKER_ERR for fail or no matchup
+   * comment: combinations with a card not in last_pile or on board are removed, a matchup
+              same with another after exchanging colors is calculated once, ranges whose numbers
+              of combinations multiply to more than POKER_RANGE_MATCHUP are refused */
+int POKER_Calc_RangeEquity(DECK_TP deck, const RANGE_T *range, int range_num, const int *board, int board_num,
+                           int trials, int threads, EQUITY_T *equity)
+{
+    RANGE_JOB_T job;
+    unsigned long long dead = 0;
+    int bit = 0;
+    int idx = 0;
+    int rv = POKER_ERR;
+
+    if ((deck == NULL) || (range == NULL) || (equity == NULL)) return POKER_ERR;
+    if (POKER_Get_LastCardNum(deck) < 0) return POKER_ERR;    /* a cursor is open */
+    if ((range_num < 2) || (range_num > POKER_EQUITY_PLAYER)) return POKER_ERR;
+    if ((board_num < 0) || (board_num > EQUITY_BOARD)) return POKER_ERR;
+    if ((board == NULL) && (board_num > 0)) return POKER_ERR;
+    if ((trials < 0) || (trials > EQUITY_TRIALS)) return POKER_ERR;
+
+    memset(&job, 0, sizeof(job));
+    job.seat_num = range_num;
+    job.need = EQUITY_BOARD - board_num;
+    job.trials = trials;
+    for (idx = 0; idx < board_num; idx++)
+    {
+        bit = poker_card_bit[board[idx] & 0xFF];
+        if ((bit < 0) || (dead & (1ULL << bit))) return POKER_ERR;
+        dead |= 1ULL << bit;
+        eval_add(&job.known, bit);
+    }
+    job.card_num = list_cards(deck, &dead, job.card);
+
+    job.combo = (int *)malloc(range_num * POKER_RANGE_COMBO * 2 * sizeof(int));
+    job.combo_weight = (double *)malloc(range_num * POKER_RANGE_COMBO * sizeof(double));
+    if ((job.combo != NULL) && (job.combo_weight != NULL)) rv = calc_range(&job, deck, range, threads, equity);
+
+    free(job.combo);
+    free(job.combo_weight);
+    free(job.key);
+    free(job.weight);
+    free(job.equity);
+    free(job.slot);
+    return rv;
+}
@@ -0,0 +1,183 @@
+/* poker hand evaluator
+   * a hand of 5 ~ 7 cards is ranked with two lookup tables generated by gen_table at build time:
+     poker_flush_value -- indexed by the 13 bits of numbers in the flush color
+     poker_hash_value  -- indexed by a perfect hash of the sum of number keys, for hands without flush */
+#include "poker.h"
+#include "poker_table.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define EVAL_AVX2
+#endif
+
+#define EVAL_BATCH_CARD 7
+
+/* the highest value of every hand type */
+static const int type_value[POKER_HAND_STRAIGHT_FLUSH + 1] =
+{
+    0, 1277, 4137, 4995, 5853, 5863, 7140, 7296, 7452, 7462
+};
+
+/* POKER_Eval_Hand: evaluate a poker hand of 5 ~ 7 cards with the best 5 cards of it,
+   * parameter: const int *cards -- the cards, no joker and no same card twice
+                int num -- the card number, 5 ~ 7
+   * return value: the value of hand from 1 to 7462, a better hand has a bigger value,
+                   POKER_ERR for failure
+   * comment: tables of evaluator are read only data generated at build time, it is thread safe */
+int POKER_Eval_Hand(const int *cards, int num)
+{
+    EVAL_HAND_T hand;
+    int bit = 0;
+    int idx = 0;
+
+    if (cards == NULL) return POKER_ERR;
+    if ((num < EVAL_MIN_CARD) || (num > EVAL_MAX_CARD)) return POKER_ERR;
+
+    memset(&hand, 0, sizeof(hand));
+    for (idx = 0; idx < num; idx++)
+    {
+        bit = poker_card_bit[cards[idx] & 0xFF];
+        if (bit < 0) return POKER_ERR;
+        if (hand.bits & (1ULL << bit)) return POKER_ERR;
+        eval_add(&hand, bit);
+    }
+    return eval_value(&hand);
+}
+
+static void eval_batch(const int *cards, int num, int *values)
+{
+    int idx = 0;
+
+    for (idx = 0; idx < num; idx++) values[idx] = POKER_Eval_Hand(cards + idx * EVAL_BATCH_CARD, EVAL_BATCH_CARD);
+}
+
+#ifdef EVAL_AVX2
+/* 16 bits values of table at idx, 32 bits gathers read the value after them too */
+#define GATHER16(table, idx) \
+    _mm256_and_si256(_mm256_i32gather_epi32((const int *)(table), (idx), 2), _mm256_set1_epi32(0xFFFF))
+
+/* evaluate 8 hands at a time in 32 bits lanes, hands with a joker, an invalid card or same card twice
+   are left to eval_batch */
+__attribute__((target("avx2")))
+static void eval_batch_avx2(const int *cards, int num, int *values)
+{
+    const __m256i stride = _mm256_setr_epi32(0, 7, 14, 21, 28, 35, 42, 49);
+    const __m256i nibble = _mm256_set1_epi32(0x0F);
+    const __m256i two = _mm256_set1_epi32(2);
+    const __m256i one = _mm256_set1_epi32(1);
+    const __m256i zero = _mm256_setzero_si256();
+    __m256i key, colors, low, high, bad;
+    __m256i card, color, number, invalid, bit, upper, flush, mask, value;
+    int lane_bad = 0;
+    int hand = 0;
+    int idx = 0;
+
+    for (hand = 0; hand + 8 <= num; hand += 8)
+    {
+        key = colors = low = high = bad = zero;
+        for (idx = 0; idx < EVAL_BATCH_CARD; idx++)
+        {
+            card = _mm256_i32gather_epi32(cards + hand * EVAL_BATCH_CARD + idx, stride, 4);
+            color = _mm256_sub_epi32(_mm256_and_si256(_mm256_srli_epi32(card, 4), nibble), two);
+            number = _mm256_sub_epi32(_mm256_and_si256(card, nibble), two);
+            /* color 0 ~ 3 and number 0 ~ 12, an invalid card counts as club 2 */
+            invalid = _mm256_or_si256(_mm256_cmpgt_epi32(zero, color), _mm256_cmpgt_epi32(color, _mm256_set1_epi32(3)));
+            invalid = _mm256_or_si256(invalid, _mm256_cmpgt_epi32(zero, number));
+            invalid = _mm256_or_si256(invalid, _mm256_cmpgt_epi32(number, _mm256_set1_epi32(12)));
+            color = _mm256_andnot_si256(invalid, color);
+            number = _mm256_andnot_si256(invalid, number);
+            bad = _mm256_or_si256(bad, invalid);
+
+            key = _mm256_add_epi32(key, _mm256_i32gather_epi32(poker_num_key, number, 4));
+            colors = _mm256_add_epi32(colors, _mm256_sllv_epi32(one, _mm256_slli_epi32(color, 2)));
+            /* club and diamond in low, heart and spade in high, 16 bits a color */
+            bit = _mm256_sllv_epi32(one, _mm256_add_epi32(number, _mm256_slli_epi32(_mm256_and_si256(color, one), 4)));
+            upper = _mm256_cmpgt_epi32(color, one);
+            bad = _mm256_or_si256(bad, _mm256_xor_si256(_mm256_cmpeq_epi32(_mm256_and_si256(
+                      _mm256_blendv_epi8(low, high, upper), bit), zero), _mm256_set1_epi32(-1)));
+            low = _mm256_or_si256(low, _mm256_andnot_si256(upper, bit));
+            high = _mm256_or_si256(high, _mm256_and_si256(upper, bit));
+        }
+
+        /* a color of 5 cards overflows to bit 3 of its count, 7 cards have one at most */
+        flush = _mm256_and_si256(_mm256_add_epi32(colors, _mm256_set1_epi32(0x3333)), _mm256_set1_epi32(0x8888));
+        mask = _mm256_blendv_epi8(low, _mm256_srli_epi32(low, 16),
+                                  _mm256_cmpgt_epi32(_mm256_and_si256(flush, _mm256_set1_epi32(0x0080)), zero));
+        mask = _mm256_blendv_epi8(mask, high,
+                                  _mm256_cmpgt_epi32(_mm256_and_si256(flush, _mm256_set1_epi32(0x0800)), zero));
+        mask = _mm256_blendv_epi8(mask, _mm256_srli_epi32(high, 16),
+                                  _mm256_cmpgt_epi32(_mm256_and_si256(flush, _mm256_set1_epi32(0x8000)), zero));
+        mask = _mm256_and_si256(mask, _mm256_set1_epi32(EVAL_FLUSH_SIZE - 1));
+
+        /* the key of a bad hand may be no hand and out of the tables, read row 0 and slot 0 for it */
+        key = _mm256_andnot_si256(bad, _mm256_sub_epi32(key, _mm256_set1_epi32(EVAL_KEY_MIN)));
+        value = _mm256_add_epi32(_mm256_i32gather_epi32(poker_hash_offset, _mm256_srli_epi32(key, EVAL_HASH_SHIFT), 4),
+                                 _mm256_and_si256(key, _mm256_set1_epi32(EVAL_HASH_MASK)));
+        value = GATHER16(poker_hash_value, _mm256_andnot_si256(bad, value));
+        value = _mm256_blendv_epi8(value, GATHER16(poker_flush_value, mask), _mm256_cmpgt_epi32(flush, zero));
+        _mm256_storeu_si256((__m256i *)(values + hand), value);
+
+        lane_bad = _mm256_movemask_ps(_mm256_castsi256_ps(bad));
+        for (idx = 0; idx < 8; idx++)
+        {
+            if (lane_bad & (1 << idx)) eval_batch(cards + (hand + idx) * EVAL_BATCH_CARD, 1, values + hand + idx);
+        }
+    }
+    eval_batch(cards + hand * EVAL_BATCH_CARD, num - hand, values + hand);
+}
+#endif
+
+/* POKER_Eval_Batch: evaluate many hands of 7 cards,
+   * parameter: const int *cards -- 7 cards of every hand one after another
+                int num -- the number of hands
+                int *values -- the value of every hand as POKER_Eval_Hand
+   * return value: POKER_OK for success, POKER_ERR for fail
+   * comment: AVX2 evaluates 8 hands at a time if the CPU has it */
+int POKER_Eval_Batch(const int *cards, int num, int *values)
+{
+    if ((cards == NULL) || (values == NULL) || (num < 0)) return POKER_ERR;
+
+#ifdef EVAL_AVX2
+    if (__builtin_cpu_supports("avx2"))
+    {
+        eval_batch_avx2(cards, num, values);
+        return POKER_OK;
+    }
+#endif
+    eval_batch(cards, num, values);
+    return POKER_OK;
+}
+
+/* POKER_Eval_PlayerHand: evaluate the cards of a player with community cards,
+   * parameter: DECK_TP deck -- the pointer to a deck of poker
+                int player_no -- the player no
+                const int *board -- the community cards, NULL for none
+                int board_num -- the number of community cards
+   * return value: the value of hand as POKER_Eval_Hand, POKER_ERR for failure */
+int POKER_Eval_PlayerHand(DECK_TP deck, int player_no, const int *board, int board_num)
+{
+    int cards[EVAL_MAX_CARD];
+    int num = 0;
+    int idx = 0;
+
+    if ((deck == NULL) || (player_no < 1) || (board_num < 0)) return POKER_ERR;
+    if ((board == NULL) && (board_num > 0)) return POKER_ERR;
+    if ((num = POKER_Get_PlayerCardNum(deck, player_no)) < 0) return POKER_ERR;
+    if ((num + board_num < EVAL_MIN_CARD) || (num + board_num > EVAL_MAX_CARD)) return POKER_ERR;
+
+    for (idx = 0; idx < num; idx++) cards[idx] = POKER_Show_PlayerCard(deck, player_no, POKER_FROM_INDEX, idx);
+    for (idx = 0; idx < board_num; idx++) cards[num + idx] = board[idx];
+    return POKER_Eval_Hand(cards, num + board_num);
+}
+
+/* POKER_Hand_Type: get the hand type of a value from POKER_Eval_Hand,
+   * parameter: int value -- the value of hand
+   * return value: POKER_HAND_HIGH_CARD ~ POKER_HAND_STRAIGHT_FLUSH, POKER_ERR for failure */
+int POKER_Hand_Type(int value)
+{
+    int type = 0;
+
+    if ((value < 1) || (value > EVAL_HAND_NUM)) return POKER_ERR;
+    for (type = POKER_HAND_HIGH_CARD; value > type_value[type]; type++);
+    return type;
+}
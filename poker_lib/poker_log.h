@@ -0,0 +1,114 @@
+/* records of deck logs, shared by the log writer and replay in poker.c, the archive in poker_archive.c
+   and the poker_replay tool */
+#ifndef _POKER_LOG_H_
+#define _POKER_LOG_H_
+
+#include <stdint.h>
+
+/* log of a deck, every record is an operation code of 1 byte and its arguments:
+     LOG_SNAPSHOT -- the size of snapshot in 4 bytes and a snapshot of POKER_Save_Deck
+     LOG_HAND     -- hand id and time in 8 bytes, table in 4 bytes, a snapshot follows
+     others       -- poker_log_args[op] arguments of 2 bytes, little endian */
+#define LOG_SNAPSHOT        1   /* the deck is replaced: log start, entropy seed, sort of a user rule, load and copy */
+#define LOG_RESET           2   /* shuffle */
+#define LOG_SEED            3   /* seed in 4 arguments from low bits */
+#define LOG_RAND            4   /* range in 2 arguments from low bits */
+#define LOG_CUT             5   /* index */
+#define LOG_DEAL_CARD       6   /* type, index, player_no */
+#define LOG_DEAL_CARDS      7   /* num, player_no */
+#define LOG_DEAL_ROUND      8   /* num, first_player */
+#define LOG_DEAL_ALL        9   /* first_player */
+#define LOG_TRANSFER        10  /* type, index, from_player_no, to_player_no */
+#define LOG_THROW_LAST      11  /* type, index */
+#define LOG_THROW_PLAYER    12  /* player_no, type, index */
+#define LOG_THROW_PAIR      13  /* player_no */
+#define LOG_MOVE            14  /* from_pile_no, index, num, to_pile_no, type */
+#define LOG_SORT            15  /* pile_no, rule of sort_rules */
+#define LOG_SHUFFLE         16  /* pile_no */
+#define LOG_HAND            17  /* a hand starts, POKER_Mark_Hand */
+#define LOG_OP_NUM          18
+
+#define LOG_MAX_NUM         0x7FFF  /* most cards and players of a logged deck */
+#define LOG_MAX_ARG         5
+#define LOG_SNAP_HEAD       5       /* operation code and size of a snapshot record */
+#define LOG_HAND_SIZE       21      /* a hand record */
+
+/* snapshot of a deck, all numbers are little endian:
+     0  "PKD1"
+     4  bytes of a card, 1 or 2 for a shoe of more packs
+     5  joker_num, pack_num and 0
+     8  player_num, total_num, cut_num and 0, 2 bytes each
+     16 random number generator state, 4 x 8 bytes
+     48 card number of last pile, trash pile and every player, 2 bytes each
+     then cards of every pile in the same order from top, 1 byte a card or 2 bytes for a shoe */
+#define SNAP_MAGIC          "PKD1"
+#define SNAP_WIDTH          4
+#define SNAP_JOKER          5
+#define SNAP_PACK           6
+#define SNAP_PLAYER         8
+#define SNAP_TOTAL          10
+#define SNAP_CUT            12
+#define SNAP_RAND           16
+#define SNAP_HEAD_SIZE      48
+#define SNAP_MAX_NUM        0xFFFF
+
+/* arguments of every operation, LOG_HAND counts its 20 bytes as 10 */
+extern const int poker_log_args[LOG_OP_NUM];
+
+static inline void put_16(unsigned char *buf, int value)
+{
+    buf[0] = (unsigned char)(value & 0xFF);
+    buf[1] = (unsigned char)((value >> 8) & 0xFF);
+}
+
+static inline int get_16(const unsigned char *buf)
+{
+    return buf[0] | (buf[1] << 8);
+}
+
+static inline void put_32(unsigned char *buf, unsigned int value)
+{
+    put_16(buf, (int)(value & 0xFFFF));
+    put_16(buf + 2, (int)(value >> 16));
+}
+
+static inline unsigned int get_32(const unsigned char *buf)
+{
+    return (unsigned int)get_16(buf) | ((unsigned int)get_16(buf + 2) << 16);
+}
+
+static inline void put_64(unsigned char *buf, uint64_t value)
+{
+    int idx = 0;
+
+    for (idx = 0; idx < 8; idx++) buf[idx] = (unsigned char)(value >> (idx * 8));
+}
+
+static inline uint64_t get_64(const unsigned char *buf)
+{
+    uint64_t    value = 0;
+    int         idx = 0;
+
+    for (idx = 7; idx >= 0; idx--) value = (value << 8) | buf[idx];
+    return value;
+}
+
+/* the size of the record at data of size bytes left, 0 for a record cut at the end, POKER_ERR for a bad one */
+static inline long log_record_size(const unsigned char *data, size_t size)
+{
+    long len = 0;
+
+    if ((data[0] <= 0) || (data[0] >= LOG_OP_NUM)) return POKER_ERR;
+    if (data[0] == LOG_SNAPSHOT)
+    {
+        if (size < LOG_SNAP_HEAD) return 0;
+        len = LOG_SNAP_HEAD + (long)get_32(data + 1);
+    }
+    else
+    {
+        len = 1 + poker_log_args[data[0]] * 2;
+    }
+    return ((size_t)len > size) ? 0 : len;
+}
+
+#endif
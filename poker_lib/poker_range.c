@@ -0,0 +1,210 @@
+/* hand ranges of Texas Hold'em
+   * a range is a list of tokens separated by ',', every token with an optional ":weight":
+     AA, AKs, AKo, AK     -- a pair, suited, offsuit or all combinations of two numbers
+     QQ+, A2s+, KTo+      -- pairs up to AA, or the second number up to below the first
+     22-55, AKs-ATs       -- pairs, or the second number between the two
+     76s-54s              -- connectors of the same gap between the two
+     AsKh                 -- one combination, colors are c, d, h and s
+     a later token replaces the weight of a combination, weight 0 removes it */
+#include "poker.h"
+
+#define RANGE_ANY       0
+#define RANGE_SUITED    1
+#define RANGE_OFFSUIT   2
+
+static const char num_char[] = "23456789TJQKA";
+static const char color_char[] = "cdhs";
+
+/* index of a card in a pack, 0 ~ 51 */
+#define CARD_INDEX(card) ((((POKER_Color(card)) >> 4) - 2) * 13 + POKER_Num(card) - POKER_NUM_2)
+
+static int parse_num(char c)
+{
+    const char *pos = strchr(num_char, c);
+
+    if ((c == '\0') || (pos == NULL)) return POKER_ERR;
+    return (int)(pos - num_char) + POKER_NUM_2;
+}
+
+static int parse_color(char c)
+{
+    const char *pos = strchr(color_char, c);
+
+    if ((c == '\0') || (pos == NULL)) return POKER_ERR;
+    return ((int)(pos - color_char) + 2) << 4;
+}
+
+/* combination of two different cards, 0 ~ POKER_RANGE_COMBO - 1 */
+static int combo_index(int card1, int card2)
+{
+    int idx1 = CARD_INDEX(card1);
+    int idx2 = CARD_INDEX(card2);
+
+    if (idx1 < idx2) return idx2 * (idx2 - 1) / 2 + idx1;
+    return idx1 * (idx1 - 1) / 2 + idx2;
+}
+
+/* set the weight of combinations of numbers high and low */
+static void add_combo(double *weight, int high, int low, int type, double value)
+{
+    int color1 = 0;
+    int color2 = 0;
+
+    for (color1 = POKER_COLOR_CLUB; color1 <= POKER_COLOR_SPADE; color1 += 0x10)
+    {
+        for (color2 = POKER_COLOR_CLUB; color2 <= POKER_COLOR_SPADE; color2 += 0x10)
+        {
+            if ((high == low) && (color1 >= color2)) continue;
+            if ((type == RANGE_SUITED) && (color1 != color2)) continue;
+            if ((type == RANGE_OFFSUIT) && (color1 == color2)) continue;
+            weight[combo_index(color1 | high, color2 | low)] = value;
+        }
+    }
+}
+
+/* parse two numbers with an optional 's' or 'o', the higher number first,
+   return the characters parsed, POKER_ERR for failure */
+static int parse_class(const char *text, int *high, int *low, int *type)
+{
+    int num1 = parse_num(text[0]);
+    int num2 = (num1 == POKER_ERR) ? POKER_ERR : parse_num(text[1]);
+
+    if (num2 == POKER_ERR) return POKER_ERR;
+    *high = (num1 > num2) ? num1 : num2;
+    *low = (num1 > num2) ? num2 : num1;
+    *type = RANGE_ANY;
+    if (text[2] == 's') *type = RANGE_SUITED;
+    if (text[2] == 'o') *type = RANGE_OFFSUIT;
+    if ((*high == *low) && (*type != RANGE_ANY)) return POKER_ERR;
+    return (*type == RANGE_ANY) ? 2 : 3;
+}
+
+/* parse a token of len characters, spaces removed */
+static int parse_token(const char *text, int len, double *weight)
+{
+    char body[16];
+    char number[16];
+    char *end = NULL;
+    double value = 1.0;
+    int high = 0, low = 0, type = 0;
+    int high2 = 0, low2 = 0, type2 = 0;
+    int used = 0;
+    int num = 0;
+    const char *colon = memchr(text, ':', len);
+
+    if (colon != NULL)
+    {
+        /* the token is not terminated, the weight is copied out for strtod */
+        num = len - (int)(colon + 1 - text);
+        if ((num < 1) || (num >= (int)sizeof(number))) return POKER_ERR;
+        memcpy(number, colon + 1, num);
+        number[num] = '\0';
+        value = strtod(number, &end);
+        if ((end != number + num) || !((value >= 0.0) && (value <= 1.0))) return POKER_ERR;
+        len = (int)(colon - text);
+    }
+    if ((len < 2) || (len >= (int)sizeof(body))) return POKER_ERR;
+    memcpy(body, text, len);
+    body[len] = '\0';
+
+    /* one combination, as AsKh */
+    if ((len == 4) && (parse_color(body[1]) != POKER_ERR))
+    {
+        high = parse_num(body[0]) | parse_color(body[1]);
+        low = parse_num(body[2]) | parse_color(body[3]);
+        if ((high < 0) || (low < 0) || (high == low)) return POKER_ERR;
+        weight[combo_index(high, low)] = value;
+        return POKER_OK;
+    }
+
+    if ((used = parse_class(body, &high, &low, &type)) == POKER_ERR) return POKER_ERR;
+    if (body[used] == '\0')
+    {
+        add_combo(weight, high, low, type, value);
+        return POKER_OK;
+    }
+    if ((body[used] == '+') && (body[used + 1] == '\0'))
+    {
+        if (high == low)
+        {
+            for (num = high; num <= POKER_NUM_A; num++) add_combo(weight, num, num, type, value);
+        }
+        else
+        {
+            for (num = low; num < high; num++) add_combo(weight, high, num, type, value);
+        }
+        return POKER_OK;
+    }
+    if (body[used] != '-') return POKER_ERR;
+
+    text = body + used + 1;
+    if ((used = parse_class(text, &high2, &low2, &type2)) == POKER_ERR) return POKER_ERR;
+    if ((text[used] != '\0') || (type != type2) || ((high == low) != (high2 == low2))) return POKER_ERR;
+    if (high < high2)
+    {
+        num = high; high = high2; high2 = num;
+        num = low; low = low2; low2 = num;
+    }
+    if (high == low)
+    {
+        for (num = high2; num <= high; num++) add_combo(weight, num, num, type, value);
+    }
+    else if (high == high2)
+    {
+        if (low < low2) { num = low; low = low2; low2 = num; }
+        for (num = low2; num <= low; num++) add_combo(weight, high, num, type, value);
+    }
+    else if (high - low == high2 - low2)
+    {
+        for (num = 0; num <= high - high2; num++) add_combo(weight, high2 + num, low2 + num, type, value);
+    }
+    else return POKER_ERR;
+    return POKER_OK;
+}
+
+/* POKER_Parse_Range: parse a hand range of Texas Hold'em, as "QQ+, AKs, 76s-54s:0.5",
+   * parameter: const char *text -- the range
+                RANGE_T *range -- the combinations of range
+   * return value: POKER_OK for success, POKER_ERR for fail */
+int POKER_Parse_Range(const char *text, RANGE_T *range)
+{
+    double weight[POKER_RANGE_COMBO];
+    char token[64];
+    int len = 0;
+    int card1 = 0;
+    int card2 = 0;
+    int idx = 0;
+
+    if ((text == NULL) || (range == NULL)) return POKER_ERR;
+
+    memset(weight, 0, sizeof(weight));
+    for (;; text++)
+    {
+        if ((*text == ',') || (*text == '\0'))
+        {
+            if ((len > 0) && (parse_token(token, len, weight) != POKER_OK)) return POKER_ERR;
+            len = 0;
+            if (*text == '\0') break;
+        }
+        else if (*text != ' ')
+        {
+            if (len == (int)sizeof(token)) return POKER_ERR;
+            token[len++] = *text;
+        }
+    }
+
+    /* combinations in order of index, card2 from 1 and card1 below it */
+    range->combo_num = 0;
+    for (card2 = 1; card2 < POKER_CARD_NUM; card2++)
+    {
+        for (card1 = 0; card1 < card2; card1++, idx++)
+        {
+            if (weight[idx] <= 0.0) continue;
+            range->card[range->combo_num][0] = (((card2 / 13) + 2) << 4) | (card2 % 13 + POKER_NUM_2);
+            range->card[range->combo_num][1] = (((card1 / 13) + 2) << 4) | (card1 % 13 + POKER_NUM_2);
+            range->weight[range->combo_num] = weight[idx];
+            range->combo_num++;
+        }
+    }
+    return POKER_OK;
+}
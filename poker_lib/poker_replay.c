@@ -0,0 +1,178 @@
+/* replay a log of POKER_Open_Log, or a hand of an archive of POKER_Write_Archive
+   * the deck is created as the snapshot at the start of log or hand: players, jokers and packs,
+     then records are applied and the piles are printed, cards in hex
+   * usage: poker_replay log_file [records]
+            poker_replay -a archive_file log_file  -- write the hands of log as an archive
+            poker_replay -h archive_file hand_id   -- replay a hand of archive */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "poker.h"
+#include "poker_log.h"
+
+static void print_card(int index, int card, void *para)
+{
+    (void)para;
+    printf(" %03x", card);
+}
+
+static long long now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static unsigned char *read_file(const char *name, size_t *size)
+{
+    unsigned char *buf = NULL;
+    FILE *fp = NULL;
+    long len = 0;
+
+    if ((fp = fopen(name, "rb")) == NULL) return NULL;
+    if ((fseek(fp, 0, SEEK_END) == 0) && ((len = ftell(fp)) > 0) && (fseek(fp, 0, SEEK_SET) == 0))
+    {
+        if ((buf = malloc(len)) != NULL)
+        {
+            if (fread(buf, 1, len, fp) != (size_t)len)
+            {
+                free(buf);
+                buf = NULL;
+            }
+        }
+    }
+    fclose(fp);
+    *size = len;
+    return buf;
+}
+
+/* create a deck as the snapshot of the LOG_SNAPSHOT record at the start of records, replay and print it */
+static int replay(const char *name, const unsigned char *buf, size_t size, int max)
+{
+    const unsigned char *snap = buf + LOG_SNAP_HEAD;
+    DECK_TP deck = NULL;
+    size_t used = 0;
+    long long ns = 0;
+    int players = 0;
+    int num = 0;
+    int idx = 0;
+
+    if ((size < LOG_SNAP_HEAD + SNAP_HEAD_SIZE) || (buf[0] != LOG_SNAPSHOT) ||
+        (memcmp(snap, SNAP_MAGIC, 4) != 0))
+    {
+        fprintf(stderr, "%s: not a log\n", name);
+        return 1;
+    }
+
+    players = get_16(snap + SNAP_PLAYER);
+    deck = POKER_Create_DeckEx(players, snap[SNAP_JOKER], POKER_DECK_ARRAY | POKER_DECK_PACK(snap[SNAP_PACK]));
+    if (deck == NULL)
+    {
+        fprintf(stderr, "%s: can not create a deck of %d players\n", name, players);
+        return 1;
+    }
+
+    ns = now_ns();
+    num = POKER_Replay_Log(deck, buf, size, max, &used);
+    ns = now_ns() - ns;
+    if (num < 0)
+    {
+        fprintf(stderr, "%s: bad record at byte %zu\n", name, used);
+    }
+    else
+    {
+        printf("records: %d, bytes: %zu of %zu, %.1f ns per record\n", num, used, size, num ? (double)ns / num : 0.0);
+        printf("last (%d):", POKER_Get_LastCardNum(deck));
+        POKER_Dump_LastPile(deck, print_card, NULL);
+        printf("\ntrash (%d):", POKER_Get_TrashCardNum(deck));
+        POKER_Dump_TrashPile(deck, print_card, NULL);
+        printf("\n");
+        for (idx = 1; idx <= players; idx++)
+        {
+            printf("player %d (%d):", idx, POKER_Get_PlayerCardNum(deck, idx));
+            POKER_Dump_PlayerPile(deck, idx, print_card, NULL);
+            printf("\n");
+        }
+    }
+
+    POKER_Delete_Deck(&deck);
+    return (num < 0) ? 1 : 0;
+}
+
+static int write_archive(const char *archive, const char *log)
+{
+    unsigned char *buf = NULL;
+    size_t size = 0;
+    int fd = -1;
+    int rv = POKER_ERR;
+
+    if ((buf = read_file(log, &size)) == NULL)
+    {
+        fprintf(stderr, "%s: can not read\n", log);
+        return 1;
+    }
+    if ((fd = open(archive, O_WRONLY | O_CREAT | O_TRUNC, 0644)) >= 0)
+    {
+        rv = POKER_Write_Archive(fd, buf, size, 0);
+        if (close(fd) != 0) rv = POKER_ERR;
+    }
+    free(buf);
+    if (rv != POKER_OK) fprintf(stderr, "%s: can not write the hands of %s\n", archive, log);
+    return (rv == POKER_OK) ? 0 : 1;
+}
+
+static int replay_hand(const char *name, unsigned long long hand_id)
+{
+    ARCHIVE_TP archive = NULL;
+    HAND_T hand;
+    int rv = 1;
+
+    if ((archive = POKER_Open_Archive(name)) == NULL)
+    {
+        fprintf(stderr, "%s: not an archive\n", name);
+        return 1;
+    }
+    if (POKER_Find_Hand(archive, hand_id, &hand) == POKER_OK)
+    {
+        printf("hand: %llu, time: %llu, table: %d, of %lld hands\n",
+               hand.hand_id, hand.time, hand.table, POKER_Get_HandNum(archive));
+        rv = replay(name, hand.data, hand.size, -1);
+    }
+    else
+    {
+        fprintf(stderr, "%s: no hand %llu\n", name, hand_id);
+    }
+    POKER_Close_Archive(&archive);
+    return rv;
+}
+
+int main(int argc, char **argv)
+{
+    unsigned char *buf = NULL;
+    size_t size = 0;
+    int rv = 0;
+
+    if ((argc == 4) && (strcmp(argv[1], "-a") == 0)) return write_archive(argv[2], argv[3]);
+    if ((argc == 4) && (strcmp(argv[1], "-h") == 0)) return replay_hand(argv[2], strtoull(argv[3], NULL, 0));
+    if ((argc < 2) || (argc > 3) || (argv[1][0] == '-'))
+    {
+        fprintf(stderr, "usage: %s log_file [records]\n"
+                        "       %s -a archive_file log_file\n"
+                        "       %s -h archive_file hand_id\n", argv[0], argv[0], argv[0]);
+        return 1;
+    }
+
+    if ((buf = read_file(argv[1], &size)) == NULL)
+    {
+        fprintf(stderr, "%s: can not read\n", argv[1]);
+        return 1;
+    }
+    rv = replay(argv[1], buf, size, (argc > 2) ? atoi(argv[2]) : -1);
+    free(buf);
+    return rv;
+}
@@ -0,0 +1,74 @@
+/* tables of hand evaluator, poker_table.c is generated by gen_table at build time */
+#ifndef _POKER_TABLE_H_
+#define _POKER_TABLE_H_
+
+#define EVAL_NUM        13
+#define EVAL_MIN_CARD   5
+#define EVAL_MAX_CARD   7
+#define EVAL_FLUSH_SIZE (1 << EVAL_NUM)
+#define EVAL_HASH_SHIFT 9
+#define EVAL_HASH_MASK  ((1 << EVAL_HASH_SHIFT) - 1)
+#define EVAL_KEY_CARD   (1 << 23)
+#define EVAL_KEY_MIN    (EVAL_MIN_CARD * EVAL_KEY_CARD)
+#define EVAL_KEY_MAX    (EVAL_MAX_CARD * EVAL_KEY_CARD + 4 * 1479181 + 3 * 636345)
+#define EVAL_ROW_NUM    (((EVAL_KEY_MAX - EVAL_KEY_MIN) >> EVAL_HASH_SHIFT) + 1)
+#define EVAL_HAND_NUM   7462
+
+/* key of every number, the sum of keys of a hand is unique */
+extern const int poker_num_key[EVAL_NUM];
+/* bit of a card in the hand bits, 16 bits of numbers for every color, -1 for joker or invalid card */
+extern const signed char poker_card_bit[256];
+/* value of the 13 bits of numbers in the flush color, and a 0 for 32 bits gathers */
+extern const unsigned short poker_flush_value[EVAL_FLUSH_SIZE + 1];
+/* value of hand without flush at poker_hash_offset[key >> EVAL_HASH_SHIFT] + (key & EVAL_HASH_MASK),
+   key is the sum of number keys minus EVAL_KEY_MIN, a 0 at the end for 32 bits gathers */
+extern const unsigned short poker_hash_value[];
+extern const int poker_hash_offset[EVAL_ROW_NUM];
+
+/* a hand being evaluated, cards are added in any order */
+typedef struct eval_hand_s
+{
+    unsigned long long  bits;    /* bits of cards */
+    unsigned int        colors;  /* card number of every color in 4 bits */
+    int                 key;     /* sum of number keys */
+} EVAL_HAND_T;
+
+/* add a card to a hand, bit -- poker_card_bit of the card, not in hand */
+static inline void eval_add(EVAL_HAND_T *hand, int bit)
+{
+    hand->bits |= 1ULL << bit;
+    hand->colors += 1 << ((bit >> 4) * 4);
+    hand->key += poker_num_key[bit & 0x0F];
+}
+
+/* join two hands without same card */
+static inline void eval_join(EVAL_HAND_T *hand, const EVAL_HAND_T *hand1, const EVAL_HAND_T *hand2)
+{
+    hand->bits = hand1->bits | hand2->bits;
+    hand->colors = hand1->colors + hand2->colors;
+    hand->key = hand1->key + hand2->key;
+}
+
+/* value of a hand of 5 ~ 7 cards without flush, key -- the sum of number keys */
+static inline int eval_key_value(int key)
+{
+    key -= EVAL_KEY_MIN;
+    return poker_hash_value[poker_hash_offset[key >> EVAL_HASH_SHIFT] + (key & EVAL_HASH_MASK)];
+}
+
+/* value of a hand of 5 ~ 7 cards */
+static inline int eval_value(const EVAL_HAND_T *hand)
+{
+    /* a color of 5 cards overflows to bit 3 of its count */
+    unsigned int flush = (hand->colors + 0x3333) & 0x8888;
+    int color = 0;
+
+    if (flush)
+    {
+        for (color = 0; !(flush & (0x8 << (color * 4))); color++);
+        return poker_flush_value[(hand->bits >> (color * 16)) & (EVAL_FLUSH_SIZE - 1)];
+    }
+    return eval_key_value(hand->key);
+}
+
+#endif
@@ -0,0 +1,483 @@
+/* unit tests of poker_lib
+   * every test prints one line, ok or FAILED with the reason, decks are seeded so runs are repeatable
+   * usage: poker_test */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "poker.h"
+
+#define TEST_SEED       20240607ULL
+#define TEST_Z          3.09    /* normal quantile of 0.999, a fair shuffle fails one run of 1000 */
+
+typedef struct test_s
+{
+    const char  *name;
+    int         (*func)(int flag);
+} TEST_T;
+
+static const int flags[] = { POKER_DECK_LIST, POKER_DECK_ARRAY };
+
+/* chi-square critical value of dof degrees of freedom, Wilson-Hilferty approximation */
+static double chi_limit(int dof)
+{
+    double a = 2.0 / (9.0 * dof);
+    double b = 1.0 - a + TEST_Z * sqrt(a);
+
+    return dof * b * b * b;
+}
+
+static double chi_square(const long *count, int cells, double expect)
+{
+    double chi = 0;
+    int idx = 0;
+
+    for (idx = 0; idx < cells; idx++)
+        chi += (count[idx] - expect) * (count[idx] - expect) / expect;
+    return chi;
+}
+
+static int card_bit(int card)
+{
+    return __builtin_ctzll(POKER_Card_Bit(card));
+}
+
+/* every order of a 4 card player pile is equally likely after POKER_Shuffle_PlayerPile,
+   the pile is sorted before every shuffle, orders of shuffles in a row would hide a bias */
+static int test_shuffle_order(int flag)
+{
+    enum { CARDS = 4, ORDERS = 24, ROUNDS = 24000 };
+    static long count[256];
+    long hit[ORDERS];
+    DECK_TP deck = NULL;
+    int cards[CARDS];
+    int first[CARDS];
+    double chi = 0;
+    int round = 0;
+    int code = 0;
+    int idx = 0;
+    int pos = 0;
+    int num = 0;
+
+    if ((deck = POKER_Create_DeckEx(1, 0, flag)) == NULL) return POKER_ERR;
+    POKER_Seed_Deck(deck, TEST_SEED);
+    POKER_Deal_Cards(deck, CARDS, 1);
+    POKER_Sort_PlayerPile(deck, 1, POKER_Comp_ColorNum);
+    POKER_Get_PileCards(deck, 1, first, CARDS);
+    memset(count, 0, sizeof(count));
+    for (round = 0; round < ROUNDS; round++)
+    {
+        POKER_Sort_PlayerPile(deck, 1, POKER_Comp_ColorNum);
+        POKER_Shuffle_PlayerPile(deck, 1);
+        POKER_Get_PileCards(deck, 1, cards, CARDS);
+        for (pos = 0, code = 0; pos < CARDS; pos++)
+        {
+            for (idx = 0; (idx < CARDS) && (first[idx] != cards[pos]); idx++);
+            code = code * CARDS + idx;
+        }
+        count[code]++;
+    }
+    POKER_Delete_Deck(&deck);
+
+    /* the codes of orders, any other code means a card is lost or doubled */
+    for (code = 0; code < 256; code++)
+    {
+        if (((1 << (code & 3)) | (1 << ((code >> 2) & 3)) | (1 << ((code >> 4) & 3)) | (1 << (code >> 6))) == 0xF)
+            hit[num++] = count[code];
+        else if (count[code] != 0) return POKER_ERR;
+    }
+    chi = chi_square(hit, ORDERS, (double)ROUNDS / ORDERS);
+    if (chi > chi_limit(ORDERS - 1))
+    {
+        printf("chi-square %.1f > %.1f, ", chi, chi_limit(ORDERS - 1));
+        return POKER_ERR;
+    }
+    return POKER_OK;
+}
+
+/* every card is equally likely at every position of a full pack after POKER_Reset_Deck */
+static int test_shuffle_position(int flag)
+{
+    enum { ROUNDS = 20800 };
+    static long count[POKER_CARD_NUM * POKER_CARD_NUM];
+    DECK_TP deck = NULL;
+    int cards[POKER_CARD_NUM];
+    double chi = 0;
+    int dof = (POKER_CARD_NUM - 1) * (POKER_CARD_NUM - 1);
+    int round = 0;
+    int pos = 0;
+
+    if ((deck = POKER_Create_DeckEx(1, 0, flag)) == NULL) return POKER_ERR;
+    POKER_Seed_Deck(deck, TEST_SEED);
+    memset(count, 0, sizeof(count));
+    for (round = 0; round < ROUNDS; round++)
+    {
+        POKER_Reset_Deck(deck, 1);
+        if (POKER_Get_PileCards(deck, POKER_PILE_LAST, cards, POKER_CARD_NUM) != POKER_CARD_NUM) break;
+        for (pos = 0; pos < POKER_CARD_NUM; pos++)
+            count[pos * POKER_CARD_NUM + card_bit(cards[pos])]++;
+    }
+    POKER_Delete_Deck(&deck);
+    if (round < ROUNDS) return POKER_ERR;
+
+    chi = chi_square(count, POKER_CARD_NUM * POKER_CARD_NUM, (double)ROUNDS / POKER_CARD_NUM);
+    if (chi > chi_limit(dof))
+    {
+        printf("chi-square %.1f > %.1f, ", chi, chi_limit(dof));
+        return POKER_ERR;
+    }
+    return POKER_OK;
+}
+
+/* a clone shuffles as its source, its random number generator is copied */
+static int test_clone(int flag)
+{
+    DECK_TP deck = NULL;
+    DECK_TP clone = NULL;
+    int cards1[POKER_CARD_NUM];
+    int cards2[POKER_CARD_NUM];
+    int rv = POKER_ERR;
+
+    if ((deck = POKER_Create_DeckEx(2, 0, flag)) == NULL) return POKER_ERR;
+    POKER_Seed_Deck(deck, TEST_SEED);
+    POKER_Deal_Cards(deck, 5, 1);
+    if ((clone = POKER_Clone_Deck(deck)) != NULL)
+    {
+        POKER_Shuffle_LastPile(deck);
+        POKER_Shuffle_LastPile(clone);
+        if ((POKER_Get_PileCards(deck, POKER_PILE_LAST, cards1, POKER_CARD_NUM) == POKER_CARD_NUM - 5) &&
+            (POKER_Get_PileCards(clone, POKER_PILE_LAST, cards2, POKER_CARD_NUM) == POKER_CARD_NUM - 5) &&
+            (memcmp(cards1, cards2, (POKER_CARD_NUM - 5) * sizeof(int)) == 0))
+            rv = POKER_OK;
+    }
+    POKER_Delete_Deck(&clone);
+    POKER_Delete_Deck(&deck);
+    return rv;
+}
+
+/* decks in memory blocks of the same seed shuffle the same */
+static int test_init_seed(int flag)
+{
+    void *mem1[1024];
+    void *mem2[1024];
+    DECK_TP deck1 = POKER_Init_Deck(mem1, sizeof(mem1), 1, 0, flag, TEST_SEED);
+    DECK_TP deck2 = POKER_Init_Deck(mem2, sizeof(mem2), 1, 0, flag, TEST_SEED);
+    int cards1[POKER_CARD_NUM];
+    int cards2[POKER_CARD_NUM];
+
+    if ((deck1 == NULL) || (deck2 == NULL)) return POKER_ERR;
+    POKER_Reset_Deck(deck1, 1);
+    POKER_Reset_Deck(deck2, 1);
+    POKER_Get_PileCards(deck1, POKER_PILE_LAST, cards1, POKER_CARD_NUM);
+    POKER_Get_PileCards(deck2, POKER_PILE_LAST, cards2, POKER_CARD_NUM);
+    POKER_Delete_Deck(&deck1);
+    POKER_Delete_Deck(&deck2);
+    return (memcmp(cards1, cards2, sizeof(cards1)) == 0) ? POKER_OK : POKER_ERR;
+}
+
+/* cards dealt from the bottom of a cut shoe are behind the cut card, it comes out earlier */
+static int test_cut_bottom(int flag)
+{
+    enum { PACKS = 2, CUT = 20, BOTTOM = 5 };
+    DECK_TP deck = NULL;
+    int total = 0;
+    int dealt = 0;
+    int idx = 0;
+
+    if ((deck = POKER_Create_DeckEx(1, 0, flag | POKER_DECK_PACK(PACKS))) == NULL) return POKER_ERR;
+    total = POKER_Get_TotalCardNum(deck);
+    POKER_Set_CutCard(deck, total - CUT);
+    for (idx = 0; idx < BOTTOM; idx++) POKER_Deal_Card(deck, POKER_FROM_BOTTOM, 0, 1);
+    POKER_Deal_Card(deck, POKER_FROM_INDEX, total - BOTTOM - 1, 1);
+    for (dealt = 0; POKER_Check_CutCard(deck) != POKER_OK; dealt++)
+        if (POKER_Deal_Card(deck, POKER_FROM_TOP, 0, 1) != POKER_OK) break;
+    POKER_Delete_Deck(&deck);
+    return (dealt == total - CUT) ? POKER_OK : POKER_ERR;
+}
+
+/* the cut card is in the same place after bulk dealing and dealing one by one, through and past it */
+static int test_cut_deal(int flag)
+{
+    enum { PACKS = 2, CUT = 10 };
+    static const int nums[] = { 0, 50, 93, 94, 95, 100, 103 };
+    unsigned char snap1[1024];
+    unsigned char snap2[1024];
+    DECK_TP deck1 = NULL;
+    DECK_TP deck2 = NULL;
+    int size = 0;
+    int total = 0;
+    int num = 0;
+    int idx = 0;
+    int rv = POKER_OK;
+
+    for (num = 0; (num < (int)(sizeof(nums) / sizeof(nums[0]))) && (rv == POKER_OK); num++)
+    {
+        deck1 = POKER_Create_DeckEx(1, 0, flag | POKER_DECK_PACK(PACKS));
+        deck2 = POKER_Create_DeckEx(1, 0, flag | POKER_DECK_PACK(PACKS));
+        if ((deck1 == NULL) || (deck2 == NULL)) rv = POKER_ERR;
+        else
+        {
+            /* a card goes back on top, so the last pile is one card more than cut_num sees at start */
+            total = POKER_Get_TotalCardNum(deck1);
+            POKER_Set_CutCard(deck1, total - CUT);
+            POKER_Deal_Card(deck1, POKER_FROM_TOP, 0, 1);
+            POKER_Move_PileRange(deck1, 1, 0, 1, POKER_PILE_LAST, POKER_FROM_TOP);
+            POKER_Copy_Deck(deck2, deck1);
+
+            if (POKER_Deal_Cards(deck1, nums[num], 1) != POKER_OK) rv = POKER_ERR;
+            for (idx = 0; idx < nums[num]; idx++)
+                if (POKER_Deal_Card(deck2, POKER_FROM_TOP, 0, 1) != POKER_OK) rv = POKER_ERR;
+            if (POKER_Check_CutCard(deck1) != POKER_Check_CutCard(deck2)) rv = POKER_ERR;
+            if (((size = POKER_Save_Deck(deck1, snap1, sizeof(snap1))) <= 0) ||
+                (POKER_Save_Deck(deck2, snap2, sizeof(snap2)) != size) ||
+                (memcmp(snap1, snap2, size) != 0) ||
+                (POKER_Load_Deck(deck2, snap1, size) != POKER_OK)) rv = POKER_ERR;
+        }
+        POKER_Delete_Deck(&deck1);
+        POKER_Delete_Deck(&deck2);
+    }
+    return rv;
+}
+
+/* a round too big for the last pile is refused, its card number is not multiplied to wrap around */
+static int test_deal_round(int flag)
+{
+    DECK_TP deck = NULL;
+    int rv = POKER_OK;
+
+    if ((deck = POKER_Create_DeckEx(2, 0, flag)) == NULL) return POKER_ERR;
+    if ((POKER_Deal_Round(deck, 0x60000000, 1) != POKER_ERR) ||
+        (POKER_Deal_Round(deck, POKER_CARD_NUM / 2 + 1, 1) != POKER_ERR) ||
+        (POKER_Get_LastCardNum(deck) != POKER_CARD_NUM)) rv = POKER_ERR;
+    if ((POKER_Deal_Round(deck, POKER_CARD_NUM / 2, 1) != POKER_OK) || (POKER_Get_LastCardNum(deck) != 0)) rv = POKER_ERR;
+    POKER_Delete_Deck(&deck);
+    return rv;
+}
+
+/* player 0 and below are refused before a player pile is read */
+static int test_player_no(int flag)
+{
+    DECK_TP deck = NULL;
+    int board[5] = { 0x11, 0x12, 0x13, 0x14, 0x15 };
+    int player_no = 0;
+    int rv = POKER_OK;
+
+    if ((deck = POKER_Create_DeckEx(2, 0, flag)) == NULL) return POKER_ERR;
+    POKER_Deal_Round(deck, 2, 1);
+    for (player_no = -1; player_no <= 0; player_no++)
+    {
+        if ((POKER_Get_PlayerCardNum(deck, player_no) != POKER_ERR) ||
+            (POKER_Show_PlayerCard(deck, player_no, POKER_FROM_TOP, 0) != POKER_ERR) ||
+            (POKER_Deal_Card(deck, POKER_FROM_TOP, 0, player_no) != POKER_ERR) ||
+            (POKER_Throw_PlayerCard(deck, player_no, POKER_FROM_TOP, 0) != POKER_ERR) ||
+            (POKER_Transfer_PlayerCard(deck, POKER_FROM_TOP, 0, 1, player_no) != POKER_ERR) ||
+            (POKER_Eval_PlayerHand(deck, player_no, board, 5) != POKER_ERR)) rv = POKER_ERR;
+    }
+    if ((POKER_Eval_PlayerHand(NULL, 1, board, 5) != POKER_ERR) || (POKER_Get_LastCardNum(deck) != POKER_CARD_NUM - 4))
+        rv = POKER_ERR;
+    POKER_Delete_Deck(&deck);
+    return rv;
+}
+
+/* a cursor removes the kings of a wrapped last pile to trash, the deck takes no other call till it ends */
+static int test_cursor(int flag)
+{
+    DECK_TP deck = NULL;
+    CURSOR_T cursor;
+    int cards[POKER_CARD_NUM];
+    int kept[POKER_CARD_NUM];
+    int kings[POKER_CARD_NUM];
+    int num = 0;
+    int kept_num = 0;
+    int king_num = 0;
+    int card = 0;
+    int idx = 0;
+    int rv = POKER_OK;
+
+    if ((deck = POKER_Create_DeckEx(1, 0, flag)) == NULL) return POKER_ERR;
+    POKER_Seed_Deck(deck, TEST_SEED);
+    POKER_Reset_Deck(deck, 1);
+    POKER_Deal_Cards(deck, 20, 1);
+    POKER_Move_Pile(deck, 1, POKER_PILE_LAST, POKER_FROM_BOTTOM);
+    num = POKER_Get_PileCards(deck, POKER_PILE_LAST, cards, POKER_CARD_NUM);
+
+    for (card = POKER_Begin_Cursor(deck, POKER_PILE_LAST, &cursor); card >= 0; card = POKER_Next_Cursor(&cursor))
+    {
+        if ((idx >= num) || (card != cards[idx++])) rv = POKER_ERR;
+        if (POKER_Num(card) != POKER_NUM_K)
+        {
+            kept[kept_num++] = card;
+            continue;
+        }
+        kings[king_num++] = card;
+        if (POKER_Remove_CursorCard(&cursor, POKER_PILE_TRASH) != POKER_OK) rv = POKER_ERR;
+    }
+    if ((card != POKER_NONE) || (idx != num) || (king_num != 4)) rv = POKER_ERR;
+    if ((POKER_Get_PileCards(deck, POKER_PILE_LAST, cards, POKER_CARD_NUM) != POKER_ERR) ||
+        (POKER_Deal_Card(deck, POKER_FROM_TOP, 0, 1) != POKER_ERR) ||
+        (POKER_Begin_Cursor(deck, 1, &cursor) != POKER_ERR)) rv = POKER_ERR;
+    POKER_End_Cursor(&cursor);
+
+    if ((POKER_Get_PileCards(deck, POKER_PILE_LAST, cards, POKER_CARD_NUM) != kept_num) ||
+        (memcmp(cards, kept, kept_num * sizeof(int)) != 0)) rv = POKER_ERR;
+    if ((POKER_Get_PileCards(deck, POKER_PILE_TRASH, cards, POKER_CARD_NUM) != king_num) ||
+        (memcmp(cards, kings, king_num * sizeof(int)) != 0)) rv = POKER_ERR;
+    POKER_Delete_Deck(&deck);
+    return rv;
+}
+
+/* spade A, heart A against spade K, heart K preflop over every board */
+static int check_equity(DECK_TP deck)
+{
+    EQUITY_T equity;
+
+    if (POKER_Calc_Equity(deck, NULL, 0, 0, 0, 1, &equity) != POKER_OK) return POKER_ERR;
+    if ((equity.total != 1712304) || (equity.win[0] + equity.win[1] + equity.tie[0] != equity.total)) return POKER_ERR;
+    if ((equity.tie[0] != equity.tie[1]) || (equity.equity[0] < 0.82) || (equity.equity[0] > 0.83)) return POKER_ERR;
+    return POKER_OK;
+}
+
+/* equity of every board, and Monte Carlo leaves the random number generator of deck as it was */
+static int test_equity(int flag)
+{
+    DECK_TP deck = NULL;
+    DECK_TP clone = NULL;
+    EQUITY_T equity;
+    int rv = POKER_ERR;
+
+    if ((deck = POKER_Create_DeckEx(2, 0, flag)) == NULL) return POKER_ERR;
+    POKER_Seed_Deck(deck, TEST_SEED);
+    POKER_Deal_Card(deck, POKER_FROM_INDEX, 0, 1);      /* spade A */
+    POKER_Deal_Card(deck, POKER_FROM_INDEX, 12, 1);     /* heart A */
+    POKER_Deal_Card(deck, POKER_FROM_INDEX, 11, 2);     /* spade K */
+    POKER_Deal_Card(deck, POKER_FROM_INDEX, 22, 2);     /* heart K */
+    if (((clone = POKER_Clone_Deck(deck)) != NULL) && (check_equity(deck) == POKER_OK) &&
+        (POKER_Calc_Equity(deck, NULL, 0, 20000, 0, 2, &equity) == POKER_OK) &&
+        (POKER_Rand_Deck(deck, 1 << 30) == POKER_Rand_Deck(clone, 1 << 30)))
+        rv = POKER_OK;
+    POKER_Delete_Deck(&clone);
+    POKER_Delete_Deck(&deck);
+    return rv;
+}
+
+/* weights of every token, bad weights and too many matchups of ranges */
+static int test_range(int flag)
+{
+    static RANGE_T range[3];
+    DECK_TP deck = NULL;
+    EQUITY_T equity;
+    int idx = 0;
+    int rv = POKER_OK;
+
+    if (POKER_Parse_Range("KK:0.5, AA:0.5", &range[0]) != POKER_OK) return POKER_ERR;
+    if (range[0].combo_num != 12) return POKER_ERR;
+    for (idx = 0; idx < range[0].combo_num; idx++)
+        if (range[0].weight[idx] != 0.5) return POKER_ERR;
+    if (POKER_Parse_Range("AKs:0.25,AA:0.5", &range[0]) != POKER_OK) return POKER_ERR;
+    if (range[0].combo_num != 10) return POKER_ERR;
+    if ((POKER_Parse_Range("AA:nan", &range[0]) != POKER_ERR) || (POKER_Parse_Range("AA:0.5x", &range[0]) != POKER_ERR) ||
+        (POKER_Parse_Range("AA:", &range[0]) != POKER_ERR)) return POKER_ERR;
+
+    /* 1326 combinations of 3 seats are 2.3G matchups */
+    if (POKER_Parse_Range("22+, A2+, K2+, Q2+, J2+, T2+, 92+, 82+, 72+, 62+, 52+, 42+, 32", &range[0]) != POKER_OK)
+        return POKER_ERR;
+    range[1] = range[2] = range[0];
+    if ((deck = POKER_Create_DeckEx(0, 0, flag)) == NULL) return POKER_ERR;
+    if ((range[0].combo_num != POKER_RANGE_COMBO) ||
+        (POKER_Calc_RangeEquity(deck, range, 3, NULL, 0, 100, 1, &equity) != POKER_ERR)) rv = POKER_ERR;
+    POKER_Delete_Deck(&deck);
+    return rv;
+}
+
+/* batch evaluation is the same as one by one, with hands of the same card 7 times and invalid cards
+   in every lane of AVX2 */
+static int test_eval_batch(int flag)
+{
+    enum { HANDS = 40 };
+    static const int bad[] = { 0x5E, 0x00, 0x11, 0x61, 0x2F, 0x01 };
+    int cards[HANDS * 7];
+    int values[HANDS];
+    int hand = 0;
+    int idx = 0;
+
+    srand(TEST_SEED);
+    for (hand = 0; hand < HANDS; hand++)
+    {
+        for (idx = 0; idx < 7; idx++)
+            cards[hand * 7 + idx] = ((rand() % 4 + 2) << 4) | (rand() % 13 + POKER_NUM_2);
+        if (hand % 3 == 0)
+        {
+            for (idx = 0; idx < 7; idx++) cards[hand * 7 + idx] = bad[0];
+        }
+        if (hand % 5 == 1) cards[hand * 7 + hand % 7] = bad[1 + hand / 5 % 5];
+    }
+    if (POKER_Eval_Batch(cards, HANDS, values) != POKER_OK) return POKER_ERR;
+    for (hand = 0; hand < HANDS; hand++)
+        if (values[hand] != POKER_Eval_Hand(cards + hand * 7, 7)) return POKER_ERR;
+    return POKER_OK;
+}
+
+/* a transfer is counted apart from throws, if the library is built with POKER_STAT */
+static int test_stat(int flag)
+{
+    DECK_TP deck = NULL;
+    STAT_T stat;
+    int rv = POKER_ERR;
+
+    if ((deck = POKER_Create_DeckEx(2, 0, flag)) == NULL) return POKER_ERR;
+    POKER_Deal_Cards(deck, 2, 1);
+    POKER_Transfer_PlayerCard(deck, POKER_FROM_TOP, 0, 1, 2);
+    POKER_Throw_PlayerCard(deck, 1, POKER_FROM_TOP, 0);
+    switch (POKER_Get_DeckStat(deck, &stat))
+    {
+        case POKER_NONE:
+            rv = POKER_OK;
+            break;
+        case POKER_OK:
+            if ((stat.calls[POKER_STAT_TRANSFER] == 1) && (stat.calls[POKER_STAT_THROW] == 1)) rv = POKER_OK;
+            break;
+    }
+    POKER_Delete_Deck(&deck);
+    return rv;
+}
+
+static const TEST_T tests[] =
+{
+    { "shuffle_order",      test_shuffle_order },
+    { "shuffle_position",   test_shuffle_position },
+    { "clone",              test_clone },
+    { "init_seed",          test_init_seed },
+    { "cut_bottom",         test_cut_bottom },
+    { "cut_deal",           test_cut_deal },
+    { "deal_round",         test_deal_round },
+    { "player_no",          test_player_no },
+    { "cursor",             test_cursor },
+    { "equity",             test_equity },
+    { "range",              test_range },
+    { "eval_batch",         test_eval_batch },
+    { "stat",               test_stat },
+};
+
+int main(void)
+{
+    int idx = 0;
+    int flag = 0;
+    int err = 0;
+
+    for (idx = 0; idx < (int)(sizeof(tests) / sizeof(tests[0])); idx++)
+    {
+        for (flag = 0; flag < (int)(sizeof(flags) / sizeof(flags[0])); flag++)
+        {
+            printf("%s,%s: ", tests[idx].name, (flags[flag] == POKER_DECK_ARRAY) ? "array" : "list");
+            if (tests[idx].func(flags[flag]) == POKER_OK)
+            {
+                printf("ok\n");
+                continue;
+            }
+            printf("FAILED\n");
+            err = 1;
+        }
+    }
+    return err;
+}
@@ -0,0 +1,108 @@
+/* threads of poker_lib under the thread sanitizer
+   * decks are played on threads at the same time, one deck a thread, while other threads run
+     POKER_Calc_Equity on their own decks with its pool of workers
+   * build and run with make tsan, the library is compiled again with -fsanitize=thread
+   * usage: poker_tsan */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "poker.h"
+
+#define TSAN_DECKS      4       /* threads playing decks */
+#define TSAN_EQUITY     2       /* threads calculating equity */
+#define TSAN_GAMES      200
+#define TSAN_WORKERS    4       /* workers of every POKER_Calc_Equity */
+#define TSAN_TRIALS     20000
+
+typedef struct tsan_s
+{
+    int         no;
+    int         err;
+    pthread_t   tid;
+} TSAN_T;
+
+/* reset, cut, deal, sort and throw the cards of one deck, the trash pile is shuffled back to last pile */
+static void *play_deck(void *para)
+{
+    TSAN_T *tsan = (TSAN_T *)para;
+    DECK_TP deck = NULL;
+    int game = 0;
+    int player = 0;
+
+    deck = POKER_Create_DeckEx(4, 2, (tsan->no & 1) ? POKER_DECK_ARRAY : POKER_DECK_LIST);
+    if (deck == NULL)
+    {
+        tsan->err = 1;
+        return NULL;
+    }
+    POKER_Seed_Deck(deck, tsan->no);
+    for (game = 0; game < TSAN_GAMES; game++)
+    {
+        POKER_Reset_Deck(deck, 1);
+        POKER_Set_CutCard(deck, 10);
+        POKER_Deal_Round(deck, 5, 1);
+        for (player = 1; player <= 4; player++)
+        {
+            POKER_Sort_PlayerPile(deck, player, POKER_Comp_NumColor);
+            POKER_Throw_PlayerCard(deck, player, POKER_FROM_TOP, 0);
+        }
+        POKER_Shuffle_TrashPile(deck);
+        if (POKER_Get_LastCardNum(deck) != POKER_Get_TotalCardNum(deck) - 16) tsan->err = 1;
+    }
+    POKER_Delete_Deck(&deck);
+    return NULL;
+}
+
+/* AA against KK preflop, Monte Carlo on the workers of POKER_Calc_Equity */
+static void *calc_equity(void *para)
+{
+    TSAN_T *tsan = (TSAN_T *)para;
+    DECK_TP deck = NULL;
+    EQUITY_T equity;
+
+    if ((deck = POKER_Create_DeckEx(2, 0, POKER_DECK_ARRAY)) == NULL)
+    {
+        tsan->err = 1;
+        return NULL;
+    }
+    POKER_Seed_Deck(deck, tsan->no);
+    POKER_Deal_Card(deck, POKER_FROM_INDEX, 0, 1);      /* spade A */
+    POKER_Deal_Card(deck, POKER_FROM_INDEX, 12, 1);     /* heart A */
+    POKER_Deal_Card(deck, POKER_FROM_INDEX, 11, 2);     /* spade K */
+    POKER_Deal_Card(deck, POKER_FROM_INDEX, 22, 2);     /* heart K */
+    if (POKER_Calc_Equity(deck, NULL, 0, TSAN_TRIALS, 0, TSAN_WORKERS, &equity) != POKER_OK) tsan->err = 1;
+    else if ((equity.equity[0] < 0.75) || (equity.equity[0] > 0.88)) tsan->err = 1;
+    POKER_Delete_Deck(&deck);
+    return NULL;
+}
+
+int main(void)
+{
+    TSAN_T tsan[TSAN_DECKS + TSAN_EQUITY];
+    int idx = 0;
+    int err = 0;
+
+    memset(tsan, 0, sizeof(tsan));
+    for (idx = 0; idx < TSAN_DECKS + TSAN_EQUITY; idx++)
+    {
+        tsan[idx].no = idx + 1;
+        if (pthread_create(&tsan[idx].tid, NULL, (idx < TSAN_DECKS) ? play_deck : calc_equity, &tsan[idx]) != 0)
+        {
+            fprintf(stderr, "can not create thread %d\n", idx);
+            return 1;
+        }
+    }
+    for (idx = 0; idx < TSAN_DECKS + TSAN_EQUITY; idx++)
+    {
+        pthread_join(tsan[idx].tid, NULL);
+        if (tsan[idx].err)
+        {
+            fprintf(stderr, "%s thread %d failed\n", (idx < TSAN_DECKS) ? "deck" : "equity", idx);
+            err = 1;
+        }
+    }
+    printf("%d deck threads, %d equity threads: %s\n", TSAN_DECKS, TSAN_EQUITY, err ? "FAILED" : "ok");
+    return err;
+}